@@ -0,0 +1,231 @@
+#version 330 core
+// Scene fragment shader. Variants are built by injecting ShaderFeature #defines
+// (see src/render/shader_variants.h); edits are hot-reloaded while the city runs.
+#ifdef LIGHT_PASS
+// deferred path: surface attributes from the G-buffer (see src/render/gbuffer.h)
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gEmissive;
+uniform sampler2D gDepth;
+uniform mat4 invViewProj;
+#else
+in vec3 vNormal;
+in vec3 vFragPos;
+in vec2 vUV;
+#ifdef LIGHTMAPPED
+flat in int vChart; // facade chart of the surface's building, -1 = none
+#endif
+#endif
+#ifdef GBUFFER
+layout(location=0) out vec4 gAlbedoOut;
+layout(location=1) out vec4 gNormalOut;
+layout(location=2) out vec3 gEmissiveOut;
+#else
+out vec4 FragColor;
+#endif
+uniform vec3 lightDir; // towards the moon
+uniform vec3 viewPos;
+uniform vec3 baseColor;
+#ifdef TEXTURED
+uniform sampler2D tex;
+#endif
+#ifdef WATER
+uniform float time;
+#endif
+#ifdef LIGHTMAPPED
+// baked ambient + static lamp irradiance (see src/render/lightmap.h)
+uniform sampler2D lightmap;
+uniform samplerBuffer lightmapCharts; // 3 texels per building: bounds, atlas x/y + rows + height, side widths
+uniform int lightmapBuildings;        // -1 = no lightmap
+uniform vec4 lightmapGround;          // ground chart min.xz, max.xz
+uniform ivec2 lightmapGroundSize;
+uniform float dissolve; // 0 = solid; buildings handing over to their impostor drop this share of pixels
+
+// 4x4 ordered dither threshold in (0, 1); the impostor shader (src/render/impostor.cpp)
+// keeps exactly the pixels a dissolving building drops
+float screenDoor(vec2 fragCoord) {
+    ivec2 p = ivec2(fragCoord) & 3;
+    int v = p.x ^ p.y;
+    return float(((v & 1) << 3) | ((p.y & 1) << 2) | (v & 2) | ((p.y >> 1) & 1)) * (1.0 / 16.0) + (0.5 / 16.0);
+}
+
+// a = 0 where the surface has no chart (roofs, props), which are then lit per pixel
+vec4 bakedLighting(vec3 N, vec3 P, int chart) {
+    if (lightmapBuildings < 0) return vec4(0.0);
+    vec2 texel;
+    if (N.y > 0.7 && P.y < 0.1) {
+        vec2 t = clamp((P.xz - lightmapGround.xy) / (lightmapGround.zw - lightmapGround.xy), 0.0, 1.0);
+        texel = t * vec2(lightmapGroundSize - 1) + 0.5;
+    } else if (abs(N.y) < 0.3 && chart >= 0 && chart < lightmapBuildings) {
+        // facade: the matching side of its building's bounding box
+        bool alongZ = abs(N.x) > abs(N.z);
+        vec4 bounds = texelFetch(lightmapCharts, chart * 3);
+        vec4 atlas = texelFetch(lightmapCharts, chart * 3 + 1);
+        vec2 sides = texelFetch(lightmapCharts, chart * 3 + 2).xy;
+        if (P.y > atlas.w + 0.05) return vec4(0.0);
+        // sides unrolled as +x, +z, -x, -z
+        int face = alongZ ? (N.x > 0.0 ? 0 : 2) : (N.z > 0.0 ? 1 : 3);
+        float n = alongZ ? sides.y : sides.x;
+        float u = alongZ ? (P.z - bounds.y) / (bounds.w - bounds.y) : (P.x - bounds.x) / (bounds.z - bounds.x);
+        float start = face == 0 ? 0.0 : face == 1 ? sides.y : face == 2 ? sides.y + sides.x : 2.0 * sides.y + sides.x;
+        texel = atlas.xy + vec2(start + clamp(u, 0.0, 1.0) * (n - 1.0), clamp(P.y / atlas.w, 0.0, 1.0) * (atlas.z - 1.0)) + 0.5;
+    } else {
+        return vec4(0.0);
+    }
+    return vec4(texture(lightmap, texel / vec2(textureSize(lightmap, 0))).rgb, 1.0);
+}
+#endif
+#if !defined(EMISSIVE) && !defined(GBUFFER)
+// clustered street lamp lights (see src/render/light_clusters.h)
+uniform mat4 view;
+uniform samplerBuffer lightData;     // 2 texels per light: position + radius, color + baked flag
+uniform usamplerBuffer clusterCells; // per cluster: offset, count into lightIndices
+uniform usamplerBuffer lightIndices;
+uniform int clusterSlices;           // 0 = lamp lighting off
+uniform ivec2 clusterTiles;
+uniform vec2 clusterTileSize;        // pixels per tile
+uniform float clusterZScale, clusterZBias;
+
+// skipBaked: the surface's lightmap already holds the static lamps
+vec3 lampLighting(vec3 N, vec3 P, vec3 V, vec3 color, bool skipBaked) {
+    if (clusterSlices == 0) return vec3(0.0);
+    float depth = -(view * vec4(P, 1.0)).z;
+    int slice = clamp(int(log(depth) * clusterZScale + clusterZBias), 0, clusterSlices - 1);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy / clusterTileSize), clusterTiles - 1);
+    uvec2 cell = texelFetch(clusterCells, (slice * clusterTiles.y + tile.y) * clusterTiles.x + tile.x).xy;
+    vec3 sum = vec3(0.0);
+    for (uint i = 0u; i < cell.y; i++) {
+        int light = int(texelFetch(lightIndices, int(cell.x + i)).r);
+        vec4 colorBaked = texelFetch(lightData, light * 2 + 1);
+        if (skipBaked && colorBaked.a > 0.5) continue;
+        vec4 posRadius = texelFetch(lightData, light * 2);
+        vec3 lightColor = colorBaked.rgb;
+        vec3 Lv = posRadius.xyz - P;
+        float d = length(Lv);
+        float window = clamp(1.0 - pow(d / posRadius.w, 4.0), 0.0, 1.0);
+        float att = window * window / (1.0 + d * d);
+        vec3 L = Lv / max(d, 1e-4);
+        float diff = max(dot(N, L), 0.0);
+        float spec = pow(max(dot(N, normalize(L + V)), 0.0), 32.0) * 0.3;
+        sum += (diff * color + spec) * lightColor * att;
+    }
+    return sum;
+}
+
+
+// moon shadows (see src/render/shadow_cascades.h): camera cascades first, then the city one
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[3];  // world -> [0,1] shadow map space, per cascade
+uniform float shadowTexelSize[3]; // world units per texel
+uniform int shadowCascades;       // 0 = no shadows
+
+float moonShadow(vec3 N, vec3 P) {
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    for (int c = 0; c < shadowCascades; c++) {
+        // normal offset against acne, scaled to the cascade's texel size
+        vec3 s = (shadowMatrices[c] * vec4(P + N * shadowTexelSize[c] * 1.5, 1.0)).xyz;
+        if (any(lessThan(s.xy, texel * 2.0)) || any(greaterThan(s.xy, 1.0 - texel * 2.0)) || s.z > 1.0) continue;
+        float lit = 0.0;
+        for (int i = 0; i < 4; i++) {
+            vec2 o = vec2((i & 1) == 0 ? -0.5 : 0.5, (i & 2) == 0 ? -0.5 : 0.5) * texel;
+            lit += texture(shadowMap, vec4(s.xy + o, float(c), s.z));
+        }
+        return lit * 0.25;
+    }
+    return 1.0;
+}
+
+// Night lighting of one surface point: low ambient, shadowed moonlight and the lamps.
+// With baked.a = 1 the surface takes ambient + static lamps from baked.rgb instead.
+vec3 shade(vec3 N, vec3 P, vec3 color, float shininess, float specStrength, vec4 baked) {
+    vec3 L = lightDir;
+    float shadow = dot(N, L) > 0.0 ? moonShadow(N, P) : 0.0;
+    float diff = max(dot(N,L), 0.0) * shadow;
+    bool skipBaked = baked.a > 0.5;
+    vec3 ambient = skipBaked ? baked.rgb * color : 0.15 * color;
+    vec3 diffuse = diff * color * 0.6;
+    vec3 viewDir = normalize(viewPos - P);
+    vec3 H = normalize(L + viewDir);
+    vec3 specular = vec3(specStrength) * pow(max(dot(N,H), 0.0), shininess) * shadow;
+    return ambient + diffuse + specular + lampLighting(N, P, viewDir, color, skipBaked);
+}
+#endif
+#ifdef GBUFFER
+// octahedral normal packing: unit vector -> [-1,1]^2
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0) e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return e;
+}
+#endif
+#ifdef LIGHT_PASS
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+#endif
+void main(){
+#if defined(DEPTH_ONLY)
+    // shadow casters: depth is all that's kept
+#elif defined(LIGHT_PASS)
+    ivec2 px = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, px, 0).r;
+    if (depth >= 1.0) discard; // nothing drawn: keep the sky
+    vec4 albedo = texelFetch(gAlbedo, px, 0);
+    vec4 surface = texelFetch(gNormal, px, 0);
+    vec4 ndc = vec4(gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 world = invViewProj * ndc;
+    vec3 result = texelFetch(gEmissive, px, 0).rgb;
+    // 0 unlit, 0.5 lit, 1 lit with ambient + static lamps already baked into the emissive target
+    if (albedo.a > 0.25)
+        result += shade(decodeNormal(surface.xy), world.xyz / world.w, albedo.rgb, surface.w * 128.0, surface.z,
+                        vec4(0.0, 0.0, 0.0, albedo.a > 0.75 ? 1.0 : 0.0));
+    FragColor = vec4(result, 1.0);
+    gl_FragDepth = depth; // so impostors drawn afterwards are depth tested against the scene
+#elif defined(EMISSIVE)
+#ifdef GBUFFER
+    gAlbedoOut = vec4(0.0);
+    gNormalOut = vec4(0.0);
+    gEmissiveOut = baseColor;
+#else
+    FragColor = vec4(baseColor, 1.0);
+#endif
+#else
+#ifdef LIGHTMAPPED
+    if (screenDoor(gl_FragCoord.xy) < dissolve) discard;
+#endif
+    vec3 N = normalize(vNormal);
+    vec2 uv = vUV;
+#ifdef WATER
+    // fine ripples on top of the vertex shader's swells: perturb the normal and the texture lookup
+    vec2 p = vFragPos.xz;
+    float w1 = sin(p.x * 1.7 + time * 1.3), w2 = sin(p.y * 2.3 - time * 1.1);
+    N = normalize(N + vec3(w1, 0.0, w2) * 0.08);
+    uv += vec2(w2, w1) * 0.01;
+    float shininess = 64.0, specStrength = 0.4; // sharper highlights on water
+#else
+    float shininess = 16.0, specStrength = 0.2; // subtle specular for natural materials
+#endif
+#ifdef TEXTURED
+    vec3 color = texture(tex, uv).rgb;
+#else
+    vec3 color = baseColor;
+#endif
+#ifdef LIGHTMAPPED
+    vec4 baked = bakedLighting(N, vFragPos, vChart);
+#else
+    vec4 baked = vec4(0.0);
+#endif
+
+#ifdef GBUFFER
+    // baked light needs nothing but the surface color, so it leaves with the emissive term
+    gAlbedoOut = vec4(color, baked.a > 0.5 ? 1.0 : 0.5);
+    gNormalOut = vec4(encodeNormal(N), specStrength, shininess / 128.0);
+    gEmissiveOut = baked.rgb * color;
+#else
+    FragColor = vec4(shade(N, vFragPos, color, shininess, specStrength, baked), 1.0);
+#endif
+#endif
+}
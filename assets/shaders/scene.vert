@@ -0,0 +1,78 @@
+#version 330 core
+// Scene vertex shader. Variants are built by injecting ShaderFeature #defines
+// (see src/render/shader_variants.h); edits are hot-reloaded while the city runs.
+#ifdef LIGHT_PASS
+// deferred light pass: one triangle covering the screen, no vertex buffer
+void main(){
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+}
+#else
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec3 aNormal;
+layout(location=2) in vec2 aUV;
+#ifdef INSTANCED
+layout(location=3) in mat4 aModel; // per instance; normals exact for rotation + uniform scale, or for boxes
+#else
+uniform mat4 model;
+#endif
+uniform mat4 view;
+uniform mat4 proj;
+#ifdef LIGHTMAPPED
+layout(location=7) in float aChart; // lightmap facade chart + 1 (GeometryArena), 0 = none
+flat out int vChart;
+#endif
+#if !defined(UNIFORM_SCALE) && !defined(INSTANCED)
+uniform mat3 normalMatrix; // inverse-transpose of model, computed on the CPU per draw
+#endif
+#ifdef WATER
+// Water swells, evaluated in world space from the time uniform only, so any number of
+// water surfaces animate without CPU work. The mesh must be a tessellated unit disc
+// (MeshCache::disc); waves fade out towards its rim so the shore line stays put.
+uniform float time;
+const int kWaves = 3;
+const vec4 kWave[kWaves] = vec4[](     // direction xy, wavenumber, angular speed
+    vec4( 0.80,  0.60, 0.9, 1.1),
+    vec4(-0.45,  0.89, 1.6, 1.7),
+    vec4( 0.17, -0.98, 2.7, 2.3));
+const float kAmplitude[kWaves] = float[](0.025, 0.012, 0.006);
+
+// height and its xz gradient at world position p
+float waterHeight(vec2 p, out vec2 grad) {
+    float h = 0.0;
+    grad = vec2(0.0);
+    for (int i = 0; i < kWaves; i++) {
+        float phase = dot(kWave[i].xy, p) * kWave[i].z - time * kWave[i].w;
+        h += kAmplitude[i] * sin(phase);
+        grad += kAmplitude[i] * kWave[i].z * cos(phase) * kWave[i].xy;
+    }
+    return h;
+}
+#endif
+out vec3 vNormal;
+out vec3 vFragPos;
+out vec2 vUV;
+void main(){
+#ifdef INSTANCED
+    mat4 model = aModel;
+#endif
+    vFragPos = vec3(model * vec4(aPos,1.0));
+#if defined(UNIFORM_SCALE) || defined(INSTANCED)
+    vNormal = mat3(model) * aNormal; // only rotation + uniform scale, renormalized per fragment
+#else
+    vNormal = normalMatrix * aNormal;
+#endif
+    vUV = aUV;
+#ifdef LIGHTMAPPED
+    vChart = int(aChart + 0.5) - 1;
+#endif
+#ifdef WATER
+    vec2 grad;
+    float fade = 1.0 - smoothstep(0.7, 1.0, length(aPos.xz));
+    vFragPos.y += waterHeight(vFragPos.xz, grad) * fade;
+    vNormal = vec3(-grad.x * fade, 1.0, -grad.y * fade);
+    vUV += vec2(0.011, 0.007) * time; // slow drift of the surface texture
+#endif
+    gl_Position = proj * view * vec4(vFragPos, 1.0);
+}
+#endif
@@ -0,0 +1,314 @@
+#include "bvh.h"
+#include "../core/worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+const int kBins = 12;
+const uint32_t kMaxLeafSize = 4;
+const uint32_t kParallelThreshold = 4096; // nodes this large bin in parallel and fork their children
+const uint32_t kInlineStack = 64;         // traversal stack kept on the call stack up to this size
+
+struct Bin {
+    glm::vec3 bmin = glm::vec3(1e30f);
+    glm::vec3 bmax = glm::vec3(-1e30f);
+    uint32_t count = 0;
+    void grow(const AABB& b) { bmin = glm::min(bmin, b.min); bmax = glm::max(bmax, b.max); }
+    void merge(const Bin& o) { bmin = glm::min(bmin, o.bmin); bmax = glm::max(bmax, o.bmax); count += o.count; }
+};
+
+float area(const glm::vec3& lo, const glm::vec3& hi) {
+    glm::vec3 e = hi - lo;
+    if (e.x < 0.0f) return 0.0f;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+// slab test; returns entry distance or +inf
+inline float rayBox(const glm::vec3& o, const glm::vec3& invDir, const glm::vec3& lo, const glm::vec3& hi, float tMax) {
+    float tx1 = (lo.x - o.x) * invDir.x, tx2 = (hi.x - o.x) * invDir.x;
+    float tmin = std::min(tx1, tx2), tmax = std::max(tx1, tx2);
+    float ty1 = (lo.y - o.y) * invDir.y, ty2 = (hi.y - o.y) * invDir.y;
+    tmin = std::max(tmin, std::min(ty1, ty2)); tmax = std::min(tmax, std::max(ty1, ty2));
+    float tz1 = (lo.z - o.z) * invDir.z, tz2 = (hi.z - o.z) * invDir.z;
+    tmin = std::max(tmin, std::min(tz1, tz2)); tmax = std::min(tmax, std::max(tz1, tz2));
+    if (tmax >= std::max(tmin, 0.0f) && tmin < tMax) return std::max(tmin, 0.0f);
+    return 1e30f;
+}
+
+// Node stack for one traversal: on the call stack when the tree is shallow enough,
+// else on the heap, sized from the depth measured at build time
+struct TraversalStack {
+    uint32_t inlineEntries[kInlineStack];
+    std::vector<uint32_t> heapEntries;
+    uint32_t* entries = inlineEntries;
+    explicit TraversalStack(uint32_t size) {
+        if (size <= kInlineStack) return;
+        heapEntries.resize(size);
+        entries = heapEntries.data();
+    }
+};
+
+} // namespace
+
+// Hands out child pairs to the (possibly parallel) recursive build; node 0 is the root
+struct BVH::NodeAllocator {
+    std::atomic<uint32_t> next{1};
+    uint32_t allocPair() { return next.fetch_add(2); }
+};
+
+void BVH::updateBounds(BVHNode& node) const {
+    node.bmin = glm::vec3(1e30f);
+    node.bmax = glm::vec3(-1e30f);
+    for (uint32_t i = 0; i < node.count; i++) {
+        const AABB& b = leafBoxes[node.leftOrFirst + i];
+        node.bmin = glm::min(node.bmin, b.min);
+        node.bmax = glm::max(node.bmax, b.max);
+    }
+}
+
+void BVH::build(const std::vector<AABB>& boxes, WorkerPool* pool) {
+    uint32_t n = (uint32_t)boxes.size();
+    primIds.resize(n);
+    leafBoxes = boxes;
+    centroids.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        primIds[i] = i;
+        centroids[i] = (boxes[i].min + boxes[i].max) * 0.5f;
+    }
+    nodes.assign(std::max<size_t>(1, 2 * (size_t)n), BVHNode());
+    usedNodes = 0;
+    if (n == 0) return;
+
+    NodeAllocator alloc;
+    nodes[0].leftOrFirst = 0;
+    nodes[0].count = n;
+    buildNode(0, 0, n, pool, alloc);
+    usedNodes = alloc.next.load();
+    nodes.resize(usedNodes);
+
+    // depth first traversal holds at most one pending sibling per level, plus the node
+    // itself; children come after their parent, so one forward sweep finds the depth
+    std::vector<uint32_t> depth(usedNodes, 0);
+    uint32_t maxDepth = 0;
+    for (size_t i = 0; i < usedNodes; i++) {
+        maxDepth = std::max(maxDepth, depth[i]);
+        if (nodes[i].count == 0) depth[nodes[i].leftOrFirst] = depth[nodes[i].leftOrFirst + 1] = depth[i] + 1;
+    }
+    stackSize = maxDepth + 2;
+    centroids.clear();
+    centroids.shrink_to_fit();
+}
+
+void BVH::buildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, WorkerPool* pool, NodeAllocator& allocator) {
+    BVHNode& node = nodes[nodeIndex];
+    node.leftOrFirst = first;
+    node.count = count;
+    bool parallel = pool && count >= kParallelThreshold;
+
+    // node bounds + centroid bounds (chunked in parallel for big nodes)
+    struct Extents { glm::vec3 lo = glm::vec3(1e30f), hi = glm::vec3(-1e30f), clo = glm::vec3(1e30f), chi = glm::vec3(-1e30f); };
+    auto extentsOf = [&](uint32_t b, uint32_t e) {
+        Extents x;
+        for (uint32_t i = b; i < e; i++) {
+            x.lo = glm::min(x.lo, leafBoxes[i].min); x.hi = glm::max(x.hi, leafBoxes[i].max);
+            x.clo = glm::min(x.clo, centroids[i]);   x.chi = glm::max(x.chi, centroids[i]);
+        }
+        return x;
+    };
+    Extents ext;
+    if (parallel) {
+        const uint32_t chunks = 64;
+        std::vector<Extents> partial(chunks);
+        pool->parallelFor(chunks, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; c++)
+                partial[c] = extentsOf(first + (uint32_t)(count * c / chunks), first + (uint32_t)(count * (c + 1) / chunks));
+        });
+        for (auto& p : partial) {
+            ext.lo = glm::min(ext.lo, p.lo); ext.hi = glm::max(ext.hi, p.hi);
+            ext.clo = glm::min(ext.clo, p.clo); ext.chi = glm::max(ext.chi, p.chi);
+        }
+    } else {
+        ext = extentsOf(first, first + count);
+    }
+    node.bmin = ext.lo;
+    node.bmax = ext.hi;
+    if (count <= kMaxLeafSize) return;
+
+    // binned SAH over the centroid bounds on all three axes
+    int bestAxis = -1, bestSplit = 0;
+    float bestCost = area(ext.lo, ext.hi) * (float)count; // cost of keeping a leaf
+    Bin bins[3][kBins];
+    auto binRange = [&](uint32_t b, uint32_t e, Bin (&out)[3][kBins]) {
+        for (int axis = 0; axis < 3; axis++) {
+            float lo = ext.clo[axis], extent = ext.chi[axis] - lo;
+            if (extent <= 0.0f) continue;
+            float scale = kBins / extent;
+            for (uint32_t i = b; i < e; i++) {
+                int bin = std::min(kBins - 1, (int)((centroids[i][axis] - lo) * scale));
+                out[axis][bin].count++;
+                out[axis][bin].grow(leafBoxes[i]);
+            }
+        }
+    };
+    if (parallel) {
+        const uint32_t chunks = 64;
+        std::vector<Bin> partial(chunks * 3 * kBins);
+        pool->parallelFor(chunks, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; c++) {
+                Bin local[3][kBins];
+                binRange(first + (uint32_t)(count * c / chunks), first + (uint32_t)(count * (c + 1) / chunks), local);
+                std::copy(&local[0][0], &local[0][0] + 3 * kBins, &partial[c * 3 * kBins]);
+            }
+        });
+        for (uint32_t c = 0; c < chunks; c++)
+            for (int a = 0; a < 3; a++)
+                for (int k = 0; k < kBins; k++) bins[a][k].merge(partial[c * 3 * kBins + a * kBins + k]);
+    } else {
+        binRange(first, first + count, bins);
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        if (ext.chi[axis] - ext.clo[axis] <= 0.0f) continue;
+        // sweep: left areas/counts forwards, right backwards
+        float leftArea[kBins - 1], rightArea[kBins - 1];
+        uint32_t leftCount[kBins - 1], rightCount[kBins - 1];
+        Bin l, r;
+        for (int k = 0; k < kBins - 1; k++) {
+            l.merge(bins[axis][k]);
+            leftArea[k] = area(l.bmin, l.bmax); leftCount[k] = l.count;
+            r.merge(bins[axis][kBins - 1 - k]);
+            rightArea[kBins - 2 - k] = area(r.bmin, r.bmax); rightCount[kBins - 2 - k] = r.count;
+        }
+        for (int k = 0; k < kBins - 1; k++) {
+            if (!leftCount[k] || !rightCount[k]) continue;
+            float cost = leftArea[k] * leftCount[k] + rightArea[k] * rightCount[k];
+            if (cost < bestCost) { bestCost = cost; bestAxis = axis; bestSplit = k; }
+        }
+    }
+
+    uint32_t mid;
+    if (bestAxis < 0) {
+        if (count <= kMaxLeafSize * 4) return; // SAH says a leaf is cheaper
+        // degenerate centroids: split in the middle so leaves stay small
+        mid = first + count / 2;
+    } else {
+        float lo = ext.clo[bestAxis], scale = kBins / (ext.chi[bestAxis] - lo);
+        uint32_t i = first, j = first + count - 1;
+        while (i <= j) {
+            int bin = std::min(kBins - 1, (int)((centroids[i][bestAxis] - lo) * scale));
+            if (bin <= bestSplit) { i++; continue; }
+            std::swap(centroids[i], centroids[j]);
+            std::swap(leafBoxes[i], leafBoxes[j]);
+            std::swap(primIds[i], primIds[j]);
+            if (j == 0) break;
+            j--;
+        }
+        mid = i;
+        if (mid == first || mid == first + count) mid = first + count / 2;
+    }
+
+    uint32_t left = allocator.allocPair();
+    node.leftOrFirst = left;
+    node.count = 0;
+    uint32_t leftCount = mid - first, rightCount = count - leftCount;
+    if (parallel) {
+        pool->parallelFor(2, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; c++) {
+                if (c == 0) buildNode(left, first, leftCount, pool, allocator);
+                else buildNode(left + 1, mid, rightCount, pool, allocator);
+            }
+        });
+    } else {
+        buildNode(left, first, leftCount, pool, allocator);
+        buildNode(left + 1, mid, rightCount, pool, allocator);
+    }
+}
+
+void BVH::refit(const std::vector<AABB>& boxes) {
+    for (size_t i = 0; i < primIds.size(); i++) leafBoxes[i] = boxes[primIds[i]];
+    // children are always allocated after their parent, so a reverse sweep is bottom-up
+    for (size_t n = usedNodes; n-- > 0;) {
+        BVHNode& node = nodes[n];
+        if (node.count > 0) {
+            updateBounds(node);
+        } else {
+            const BVHNode& l = nodes[node.leftOrFirst];
+            const BVHNode& r = nodes[node.leftOrFirst + 1];
+            node.bmin = glm::min(l.bmin, r.bmin);
+            node.bmax = glm::max(l.bmax, r.bmax);
+        }
+    }
+}
+
+bool BVH::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, Hit& hit) const {
+    if (primIds.empty()) return false;
+    float len = glm::length(dir);
+    if (len <= 0.0f) return false;
+    glm::vec3 d = dir / len;
+    glm::vec3 inv(1.0f / d.x, 1.0f / d.y, 1.0f / d.z);
+
+    float best = maxDist;
+    int bestId = -1;
+    TraversalStack traversal(stackSize);
+    uint32_t* stack = traversal.entries;
+    uint32_t sp = 0;
+    if (rayBox(origin, inv, nodes[0].bmin, nodes[0].bmax, best) >= 1e30f) return false;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        const BVHNode& node = nodes[stack[--sp]];
+        if (node.count > 0) {
+            for (uint32_t i = 0; i < node.count; i++) {
+                const AABB& b = leafBoxes[node.leftOrFirst + i];
+                float t = rayBox(origin, inv, b.min, b.max, best);
+                if (t < best) { best = t; bestId = (int)primIds[node.leftOrFirst + i]; }
+            }
+            continue;
+        }
+        // visit the nearer child first
+        uint32_t c0 = node.leftOrFirst, c1 = node.leftOrFirst + 1;
+        float t0 = rayBox(origin, inv, nodes[c0].bmin, nodes[c0].bmax, best);
+        float t1 = rayBox(origin, inv, nodes[c1].bmin, nodes[c1].bmax, best);
+        if (t0 > t1) { std::swap(t0, t1); std::swap(c0, c1); }
+        assert(sp + 2 <= stackSize);
+        if (t1 < 1e30f) stack[sp++] = c1;
+        if (t0 < 1e30f) stack[sp++] = c0;
+    }
+    if (bestId < 0) return false;
+    hit.id = bestId;
+    hit.t = best;
+    return true;
+}
+
+bool BVH::occluded(const glm::vec3& a, const glm::vec3& b, int ignoreA, int ignoreB) const {
+    if (primIds.empty()) return false;
+    glm::vec3 dir = b - a;
+    float dist = glm::length(dir);
+    if (dist <= 0.0f) return false;
+    glm::vec3 d = dir / dist;
+    glm::vec3 inv(1.0f / d.x, 1.0f / d.y, 1.0f / d.z);
+
+    TraversalStack traversal(stackSize);
+    uint32_t* stack = traversal.entries;
+    uint32_t sp = 0;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        const BVHNode& node = nodes[stack[--sp]];
+        if (rayBox(a, inv, node.bmin, node.bmax, dist) >= 1e30f) continue;
+        if (node.count > 0) {
+            for (uint32_t i = 0; i < node.count; i++) {
+                int id = (int)primIds[node.leftOrFirst + i];
+                if (id == ignoreA || id == ignoreB) continue;
+                const AABB& box = leafBoxes[node.leftOrFirst + i];
+                if (rayBox(a, inv, box.min, box.max, dist) < 1e30f) return true; // any hit will do
+            }
+        } else {
+            assert(sp + 2 <= stackSize);
+            stack[sp++] = node.leftOrFirst + 1;
+            stack[sp++] = node.leftOrFirst;
+        }
+    }
+    return false;
+}
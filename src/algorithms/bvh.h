@@ -0,0 +1,52 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "../render/frustum.h"
+#include <cstdint>
+#include <vector>
+
+class WorkerPool;
+
+// 32-byte node; children of an interior node are stored next to each other
+struct BVHNode {
+    glm::vec3 bmin;
+    uint32_t leftOrFirst; // interior: index of the left child (right = left + 1); leaf: first primitive
+    glm::vec3 bmax;
+    uint32_t count;       // 0 for interior nodes, primitive count for leaves
+};
+
+// Bounding volume hierarchy over AABBs (object IDs = index in the input vector).
+// Built top-down with binned SAH; large nodes are binned and split in parallel.
+class BVH {
+public:
+    struct Hit {
+        int id = -1;
+        float t = 0.0f; // distance along the (normalized) ray
+    };
+
+    void build(const std::vector<AABB>& boxes, WorkerPool* pool = nullptr);
+    // Recomputes node bounds bottom-up after boxes moved; topology is kept
+    void refit(const std::vector<AABB>& boxes);
+
+    // Nearest box hit along the ray within maxDist (dir need not be normalized)
+    bool raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, Hit& hit) const;
+    // True if any box other than `ignoreA`/`ignoreB` blocks the segment from a to b
+    bool occluded(const glm::vec3& a, const glm::vec3& b, int ignoreA = -1, int ignoreB = -1) const;
+
+    size_t nodeCount() const { return usedNodes; }
+    size_t size() const { return primIds.size(); }
+    bool empty() const { return primIds.empty(); }
+private:
+    std::vector<BVHNode> nodes;
+    std::vector<uint32_t> primIds;   // leaf order -> object ID
+    std::vector<AABB> leafBoxes;     // boxes in leaf order, for cache-friendly leaf tests
+    std::vector<glm::vec3> centroids;
+    size_t usedNodes = 0;
+    uint32_t stackSize = 1;          // traversal stack entries the deepest path needs
+
+    struct NodeAllocator;
+    void buildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, WorkerPool* pool, NodeAllocator& allocator);
+    void updateBounds(BVHNode& node) const;
+};
+
+#endif // BVH_H
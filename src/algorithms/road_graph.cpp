@@ -0,0 +1,133 @@
+#include "road_graph.h"
+#include <algorithm>
+
+void RoadGraph::clear() {
+    nodeList.clear();
+    edgeList.clear();
+    pointList.clear();
+    adjacencyStart.assign(1, 0);
+    adjacencyEdge.clear();
+}
+
+void RoadGraph::build(const std::vector<std::pair<int,int>>& cells, float originX, float originZ) {
+    clear();
+    if (cells.empty()) return;
+
+    // dense lookup over the cells' bounding box, with a one cell border so neighbour
+    // reads never leave it; the value is the cell's node, kRoad, or kEmpty
+    const int32_t kEmpty = -2, kRoad = -1;
+    int minX = cells[0].first, maxX = minX, minZ = cells[0].second, maxZ = minZ;
+    for (auto& c : cells) {
+        minX = std::min(minX, c.first); maxX = std::max(maxX, c.first);
+        minZ = std::min(minZ, c.second); maxZ = std::max(maxZ, c.second);
+    }
+    int w = maxX - minX + 3, h = maxZ - minZ + 3;
+    std::vector<int32_t> grid((size_t)w * h, kEmpty);
+    auto index = [&](int x, int z) { return (size_t)(z - minZ + 1) * w + (x - minX + 1); };
+    for (auto& c : cells) grid[index(c.first, c.second)] = kRoad;
+
+    static const int kDirX[4] = { 1, 0, -1, 0 }, kDirZ[4] = { 0, 1, 0, -1 };
+    auto isRoad = [&](size_t i) { return grid[i] != kEmpty; };
+    const long step[4] = { 1, (long)w, -1, -(long)w };
+    auto toWorld = [&](int x, int z) { return glm::vec2(originX + x, originZ + z); };
+    auto addNode = [&](int x, int z, size_t i) {
+        grid[i] = (int32_t)nodeList.size();
+        Node n;
+        n.x = x; n.z = z;
+        n.position = toWorld(x, z);
+        nodeList.push_back(n);
+    };
+
+    // nodes: every cell without exactly two road neighbours, in row order
+    for (int z = minZ; z <= maxZ; z++) {
+        for (int x = minX; x <= maxX; x++) {
+            size_t i = index(x, z);
+            if (!isRoad(i)) continue;
+            int degree = 0;
+            for (int d = 0; d < 4; d++) degree += isRoad(i + step[d]) ? 1 : 0;
+            if (degree != 2) addNode(x, z, i);
+        }
+    }
+
+    // edges: walk each chain of two-neighbour cells from a node until the next node
+    std::vector<uint8_t> walked(grid.size(), 0);
+    auto trace = [&](uint32_t from, int d) {
+        int x = nodeList[from].x + kDirX[d], z = nodeList[from].z + kDirZ[d];
+        size_t i = index(x, z);
+        if (grid[i] >= 0) {
+            // adjacent nodes: one unit edge, kept from the lower node
+            if ((uint32_t)grid[i] <= from) return;
+        } else if (walked[i]) {
+            return; // already traced from its other end
+        }
+        Edge e;
+        e.from = from;
+        e.firstPoint = (uint32_t)pointList.size();
+        pointList.push_back(nodeList[from].position);
+        float length = 1.0f;
+        while (grid[i] < 0) {
+            walked[i] = 1;
+            // the one way on that isn't back
+            int nd = d;
+            for (int k = 0; k < 4; k++) {
+                if (k == (d + 2) % 4 || !isRoad(i + step[k])) continue;
+                nd = k;
+                break;
+            }
+            if (nd != d) pointList.push_back(toWorld(x, z)); // corner
+            d = nd;
+            x += kDirX[d]; z += kDirZ[d];
+            i += step[d];
+            length += 1.0f;
+        }
+        e.to = (uint32_t)grid[i];
+        pointList.push_back(nodeList[e.to].position);
+        e.pointCount = (uint32_t)pointList.size() - e.firstPoint;
+        e.length = length;
+        edgeList.push_back(e);
+    };
+    for (uint32_t n = 0; n < nodeList.size(); n++)
+        for (int d = 0; d < 4; d++)
+            if (isRoad(index(nodeList[n].x, nodeList[n].z) + step[d])) trace(n, d);
+
+    // closed loops with no node on them: their first cell becomes one
+    for (int z = minZ; z <= maxZ; z++) {
+        for (int x = minX; x <= maxX; x++) {
+            size_t i = index(x, z);
+            if (grid[i] != kRoad || walked[i]) continue;
+            addNode(x, z, i);
+            uint32_t n = (uint32_t)nodeList.size() - 1;
+            for (int d = 0; d < 4; d++) {
+                if (!isRoad(i + step[d])) continue;
+                trace(n, d); // comes back to n, marking the whole loop walked
+                break;
+            }
+        }
+    }
+
+    // CSR adjacency (a loop is listed twice at its node, once per end)
+    adjacencyStart.assign(nodeList.size() + 1, 0);
+    for (auto& e : edgeList) {
+        adjacencyStart[e.from + 1]++;
+        adjacencyStart[e.to + 1]++;
+    }
+    for (size_t n = 0; n < nodeList.size(); n++) adjacencyStart[n + 1] += adjacencyStart[n];
+    adjacencyEdge.resize(adjacencyStart.back());
+    std::vector<uint32_t> cursor(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (uint32_t e = 0; e < edgeList.size(); e++) {
+        adjacencyEdge[cursor[edgeList[e].from]++] = e;
+        adjacencyEdge[cursor[edgeList[e].to]++] = e;
+    }
+}
+
+size_t RoadGraph::intersectionCount() const {
+    size_t n = 0;
+    for (uint32_t i = 0; i < nodeList.size(); i++) n += degree(i) >= 3 ? 1 : 0;
+    return n;
+}
+
+size_t RoadGraph::deadEndCount() const {
+    size_t n = 0;
+    for (uint32_t i = 0; i < nodeList.size(); i++) n += degree(i) == 1 ? 1 : 0;
+    return n;
+}
@@ -0,0 +1,52 @@
+#ifndef ROAD_GRAPH_H
+#define ROAD_GRAPH_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Topology of a rasterized road network. Road cells are 4-connected (as from
+// bresenhamLine along the grid axes); cells with other than two road neighbours are
+// nodes (intersections, dead ends), and each chain of two-neighbour cells between
+// nodes is an edge, kept as a polyline through its corners. Node adjacency is stored
+// CSR-style: the edges at node n are edgesAt(n)[0 .. degree(n)).
+class RoadGraph {
+public:
+    struct Node {
+        int x = 0, z = 0;              // grid cell
+        glm::vec2 position = glm::vec2(0.0f); // world xz of the cell center
+    };
+    struct Edge {
+        uint32_t from = 0, to = 0;     // from <= to (equal for a loop)
+        float length = 0.0f;           // world units along the polyline
+        uint32_t firstPoint = 0, pointCount = 0; // into points(): from, corners..., to
+    };
+
+    // Cells are unit squares centered on (originX + x, originZ + z); duplicates are ignored.
+    // A loop with no node on it gets one at its first cell.
+    void build(const std::vector<std::pair<int,int>>& cells, float originX, float originZ);
+    void clear();
+
+    const std::vector<Node>& nodes() const { return nodeList; }
+    const std::vector<Edge>& edges() const { return edgeList; }
+    const std::vector<glm::vec2>& points() const { return pointList; }
+
+    uint32_t degree(uint32_t node) const { return adjacencyStart[node + 1] - adjacencyStart[node]; }
+    const uint32_t* edgesAt(uint32_t node) const { return adjacencyEdge.data() + adjacencyStart[node]; }
+    // The node at the other end of an edge at `node` (itself for a loop)
+    uint32_t otherEnd(uint32_t edge, uint32_t node) const {
+        return edgeList[edge].from == node ? edgeList[edge].to : edgeList[edge].from;
+    }
+
+    size_t intersectionCount() const; // degree 3 or more
+    size_t deadEndCount() const;      // degree 1
+private:
+    std::vector<Node> nodeList;
+    std::vector<Edge> edgeList;
+    std::vector<glm::vec2> pointList;
+    std::vector<uint32_t> adjacencyStart; // per node + 1
+    std::vector<uint32_t> adjacencyEdge;
+};
+
+#endif // ROAD_GRAPH_H
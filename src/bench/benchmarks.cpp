@@ -0,0 +1,242 @@
+// Offline benchmarks for the CPU-side geometry code (no window / GL context needed).
+// Build with `make bench`, run bin/city_bench from the project root.
+#include "../meshes/mesh.h"
+#include "../meshes/mesh_optimizer.h"
+#include "../meshes/road_mesher.h"
+#include "../meshes/building_generator.h"
+#include "../algorithms/algorithms.h"
+#include "../algorithms/bvh.h"
+#include "../algorithms/road_graph.h"
+#include "../core/worker_pool.h"
+#include "../render/light_clusters.h"
+#include "../render/lightmap.h"
+#include "../scene/traffic.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Flat n x n terrain patch, emitted row by row like a naive generator would
+static MeshData makeGridData(int n) {
+    MeshData d;
+    for (int j = 0; j <= n; j++) {
+        for (int i = 0; i <= n; i++) {
+            float x = (float)i, z = (float)j;
+            float v[8] = { x, 0.0f, z, 0, 1, 0, x / n, z / n };
+            d.verts.insert(d.verts.end(), v, v + 8);
+        }
+    }
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) {
+            unsigned int a = j*(n+1) + i, b = a + 1, c = a + (n+1), e = c + 1;
+            unsigned int q[6] = { a, c, b, b, c, e };
+            d.idx.insert(d.idx.end(), q, q + 6);
+        }
+    }
+    return d;
+}
+
+static void reportACMR(const std::string& name, MeshData data) {
+    float before = computeACMR(data.idx, data.vertexCount());
+    auto t0 = std::chrono::steady_clock::now();
+    optimizeMesh(data);
+    double ms = msSince(t0);
+    float after = computeACMR(data.idx, data.vertexCount());
+    printf("  %-30s tris %7zu  ACMR %.3f -> %.3f  (%.2f ms)\n", name.c_str(), data.triangleCount(), before, after, ms);
+}
+
+static void benchMeshOptimizer() {
+    printf("Mesh optimizer (FIFO-16 ACMR before -> after)\n");
+    reportACMR("pond fan (64 seg)", makeCircleFanData(0.0f, 0.0f, 8.0f, 64));
+    reportACMR("water disc (24 rings x 96 seg)", makeDiscData(24, 96));
+
+    int grid = 100, center = grid / 2;
+    auto roads = bresenhamLine(5, center, grid-5, center);
+    auto road2 = bresenhamLine(center, 5, center, grid-5);
+    roads.insert(roads.end(), road2.begin(), road2.end());
+    reportACMR("road strips (large city)", makeRoadStripData(groupRoadRuns(roads), -50.0f, -50.0f));
+
+    BuildingParams sky;
+    sky.width = 6.0f; sky.depth = 5.4f; sky.height = 80.0f; sky.type = 0; sky.seed = 1;
+    reportACMR("skyscraper", makeBuildingData(sky));
+
+    reportACMR("terrain grid 128x128", makeGridData(128));
+
+    // same grid with triangles in random order (worst case generator output)
+    MeshData shuffled = makeGridData(128);
+    srand(12345);
+    for (size_t t = shuffled.triangleCount() - 1; t > 0; t--) {
+        size_t r = (size_t)rand() % (t + 1);
+        for (int k = 0; k < 3; k++) std::swap(shuffled.idx[t*3 + k], shuffled.idx[r*3 + k]);
+    }
+    reportACMR("terrain grid 128x128 shuffled", shuffled);
+}
+
+// 100k scattered boxes (city blocks worth of buildings + props), random rays from above
+static void benchBVH() {
+    const int objects = 100000, rays = 200000;
+    printf("BVH (%d objects)\n", objects);
+    srand(4242);
+    auto frand = [](float lo, float hi) { return lo + (hi - lo) * (float)rand() / (float)RAND_MAX; };
+    std::vector<AABB> boxes(objects);
+    for (auto& b : boxes) {
+        glm::vec3 c(frand(-1000.0f, 1000.0f), 0.0f, frand(-1000.0f, 1000.0f));
+        glm::vec3 e(frand(0.2f, 4.0f), frand(0.5f, 40.0f), frand(0.2f, 4.0f));
+        b.min = glm::vec3(c.x - e.x, 0.0f, c.z - e.z);
+        b.max = glm::vec3(c.x + e.x, e.y * 2.0f, c.z + e.z);
+    }
+
+    BVH bvh;
+    auto t0 = std::chrono::steady_clock::now();
+    bvh.build(boxes);
+    printf("  %-30s %8.2f ms  (%zu nodes)\n", "build (1 thread)", msSince(t0), bvh.nodeCount());
+    t0 = std::chrono::steady_clock::now();
+    bvh.build(boxes, &WorkerPool::shared());
+    printf("  %-30s %8.2f ms  (%u threads)\n", "build (worker pool)", msSince(t0), WorkerPool::shared().concurrency());
+
+    for (auto& b : boxes) { b.min.x += 0.5f; b.max.x += 0.5f; }
+    t0 = std::chrono::steady_clock::now();
+    bvh.refit(boxes);
+    printf("  %-30s %8.2f ms\n", "refit", msSince(t0));
+
+    std::vector<glm::vec3> origins(rays), dirs(rays);
+    for (int i = 0; i < rays; i++) {
+        origins[i] = glm::vec3(frand(-1000.0f, 1000.0f), frand(20.0f, 120.0f), frand(-1000.0f, 1000.0f));
+        dirs[i] = glm::vec3(frand(-1.0f, 1.0f), frand(-1.0f, -0.05f), frand(-1.0f, 1.0f));
+    }
+    int hits = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rays; i++) {
+        BVH::Hit hit;
+        hits += bvh.raycast(origins[i], dirs[i], 1e9f, hit) ? 1 : 0;
+    }
+    double ms = msSince(t0);
+    printf("  %-30s %8.2f Mrays/s  (%d hits)\n", "raycast (nearest)", rays / (ms * 1000.0), hits);
+
+    int blocked = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rays; i++) {
+        glm::vec3 target(origins[i].x + dirs[i].x * 100.0f, 1.0f, origins[i].z + dirs[i].z * 100.0f);
+        blocked += bvh.occluded(origins[i], target) ? 1 : 0;
+    }
+    ms = msSince(t0);
+    printf("  %-30s %8.2f Mrays/s  (%d blocked)\n", "line of sight (any hit)", rays / (ms * 1000.0), blocked);
+}
+
+// CPU cluster binning cost as the lamp count grows (street-level camera over a 200x200 city)
+static void benchLightClusters() {
+    printf("Clustered lights (%dx%dx%d clusters)\n", LightClusters::kTilesX, LightClusters::kTilesY, LightClusters::kSlicesZ);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 25.0f, 90.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+    srand(777);
+    for (int count : { 16, 256, 4096, 16384 }) {
+        std::vector<PointLight> lights(count);
+        for (auto& l : lights) {
+            l.position = glm::vec3(-100.0f + 200.0f * rand() / RAND_MAX, 5.0f, -100.0f + 200.0f * rand() / RAND_MAX);
+            l.radius = 9.0f;
+        }
+        LightClusters clusters;
+        clusters.build(lights, view, proj, 0.1f, 200.0f); // warm-up (cluster bounds)
+        const int frames = 20;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) clusters.build(lights, view, proj, 0.1f, 200.0f);
+        double ms = msSince(t0) / frames;
+        printf("  %6d lights  %8.3f ms/frame  %8zu indices (%.1f per cluster)\n", count, ms,
+               clusters.indexCount(), (double)clusters.indexCount() / LightClusters::kClusterCount);
+    }
+}
+
+// A 100x100 city: a grid of buildings, lamps along the streets, trees in between
+static void benchLightmap() {
+    printf("Lightmap bake (%d ambient rays, %d/%d texels per unit ground/facade, %u threads)\n", Lightmap::kAmbientRays,
+           Lightmap::kGroundTexelsPerUnit, Lightmap::kFacadeTexelsPerUnit, WorkerPool::shared().concurrency());
+    LightmapInputs in;
+    srand(4242);
+    for (int bx = 0; bx < 5; bx++) {
+        for (int bz = 0; bz < 4; bz++) {
+            float x = -40.0f + bx * 20.0f, z = -30.0f + bz * 20.0f, h = 10.0f + rand() % 60;
+            in.occluders.push_back({ glm::vec3(x - 4.0f, 0.0f, z - 3.5f), glm::vec3(x + 4.0f, h, z + 3.5f) });
+        }
+    }
+    in.buildingCount = in.occluders.size();
+    for (int i = 0; i < 60; i++) {
+        float x = -45.0f + 90.0f * rand() / RAND_MAX, z = -45.0f + 90.0f * rand() / RAND_MAX;
+        in.occluders.push_back({ glm::vec3(x - 0.75f, 0.0f, z - 0.75f), glm::vec3(x + 0.75f, 3.25f, z + 0.75f) });
+    }
+    for (int i = 0; i < 40; i++) {
+        float x = -50.0f + (i % 10) * 10.0f + 5.0f, z = (i < 10) ? -40.0f : (i < 20) ? -20.0f : (i < 30) ? 0.0f : 20.0f;
+        in.lightOwners.push_back((int)in.occluders.size());
+        in.occluders.push_back({ glm::vec3(x - 0.15f, 0.0f, z - 0.15f), glm::vec3(x + 0.15f, 5.3f, z + 0.15f) });
+        PointLight l;
+        l.position = glm::vec3(x, 5.0f, z);
+        l.radius = 9.0f;
+        l.color = glm::vec3(1.0f, 0.85f, 0.6f);
+        l.intensity = 8.0f;
+        in.lights.push_back(l);
+    }
+    in.groundMin = glm::vec2(-50.0f);
+    in.groundMax = glm::vec2(50.0f);
+
+    Lightmap lightmap;
+    auto t0 = std::chrono::steady_clock::now();
+    lightmap.bake(in);
+    double ms = msSince(t0);
+    double texels = (double)lightmap.width() * lightmap.height();
+    printf("  %dx%d atlas  %8.1f ms  %6.2f Mtexels/s\n", lightmap.width(), lightmap.height(), ms, texels / (ms * 1000.0));
+    t0 = std::chrono::steady_clock::now();
+    bool cached = lightmap.save("bench_lightmap.lmap", Lightmap::layoutKey(in)) &&
+                  lightmap.load("bench_lightmap.lmap", Lightmap::layoutKey(in));
+    printf("  cache round trip %s  %8.1f ms\n", cached ? "ok" : "FAILED", msSince(t0));
+    std::remove("bench_lightmap.lmap");
+}
+
+// A 400x400 cell grid of streets every 8 cells, filled with more and more cars
+static void benchTraffic() {
+    std::vector<std::pair<int,int>> cells;
+    const int grid = 400, block = 8;
+    for (int line = 0; line <= grid; line += block) {
+        auto h = bresenhamLine(0, line, grid, line);
+        auto v = bresenhamLine(line, 0, line, grid);
+        cells.insert(cells.end(), h.begin(), h.end());
+        cells.insert(cells.end(), v.begin(), v.end());
+    }
+    RoadGraph roads;
+    auto t0 = std::chrono::steady_clock::now();
+    roads.build(cells, -grid * 0.5f, -grid * 0.5f);
+    printf("Road graph (%zu cells): %zu nodes (%zu intersections, %zu dead ends), %zu edges in %.1f ms\n", cells.size(),
+           roads.nodes().size(), roads.intersectionCount(), roads.deadEndCount(), roads.edges().size(), msSince(t0));
+    LaneGraph graph;
+    t0 = std::chrono::steady_clock::now();
+    graph.build(roads);
+    printf("Traffic (IDM, %zu lanes, %.0f units of lane, graph built in %.1f ms)\n", graph.lanes().size(), graph.totalLength(),
+           msSince(t0));
+    const int steps = 200;
+    for (size_t count : { 1000, 10000, 25000 }) {
+        for (int threaded = 0; threaded < 2; threaded++) {
+            TrafficSim sim;
+            size_t cars = sim.spawn(graph, count, 99);
+            WorkerPool* pool = threaded ? &WorkerPool::shared() : nullptr;
+            sim.step(0.016f, pool); // warm-up
+            t0 = std::chrono::steady_clock::now();
+            for (int s = 0; s < steps; s++) sim.step(0.016f, pool);
+            double ms = msSince(t0);
+            printf("  %6zu cars  %-12s %8.3f ms/step  %10.0f agents/ms\n", cars, threaded ? "worker pool" : "1 thread",
+                   ms / steps, cars * (double)steps / ms);
+        }
+    }
+}
+
+int main() {
+    benchMeshOptimizer();
+    benchBVH();
+    benchLightClusters();
+    benchLightmap();
+    benchTraffic();
+    return 0;
+}
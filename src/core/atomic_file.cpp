@@ -0,0 +1,20 @@
+#include "atomic_file.h"
+#include <filesystem>
+#include <fstream>
+
+bool writeFileAtomic(const std::string& path, const std::function<bool(std::ostream&)>& write) {
+    std::string tmp = path + ".tmp";
+    bool written;
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        written = write(out) && out.flush();
+    }
+    std::error_code ec;
+    if (written) std::filesystem::rename(tmp, path, ec);
+    if (!written || ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
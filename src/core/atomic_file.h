@@ -0,0 +1,14 @@
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+
+// Replaces `path` with what `write` puts into the stream, or leaves it untouched. The
+// data goes to a temp file next to it that is then renamed over it, so readers (and a
+// later run after a crash) see the old file or the whole new one, never a torn write.
+// `write` returns false to abandon the file.
+bool writeFileAtomic(const std::string& path, const std::function<bool(std::ostream&)>& write);
+
+#endif // ATOMIC_FILE_H
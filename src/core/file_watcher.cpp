@@ -0,0 +1,89 @@
+#include "file_watcher.h"
+#include <algorithm>
+#include <iostream>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef __linux__
+
+static void splitPath(const std::string& path, std::string& dir, std::string& name) {
+    size_t slash = path.find_last_of('/');
+    dir = (slash == std::string::npos) ? "." : path.substr(0, slash);
+    name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+FileWatcher::~FileWatcher() {
+    if (fd >= 0) close(fd);
+}
+
+bool FileWatcher::watch(const std::string& path) {
+    if (fd < 0) {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "inotify unavailable, shader hot reload disabled\n";
+            return false;
+        }
+    }
+    std::string dir, name;
+    splitPath(path, dir, name);
+    int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) {
+        std::cerr << "Cannot watch " << dir << "\n";
+        return false;
+    }
+    dirOf[wd] = dir; // the same directory returns the same descriptor
+    pathOf[dir + "/" + name] = path;
+    return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> changed;
+    if (fd < 0) return changed;
+    alignas(inotify_event) char buf[4096];
+    while (true) {
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) break; // EAGAIN: nothing pending
+        for (char* p = buf; p < buf + len;) {
+            const inotify_event* ev = (const inotify_event*)p;
+            p += sizeof(inotify_event) + ev->len;
+            if (!ev->len) continue;
+            auto dir = dirOf.find(ev->wd);
+            if (dir == dirOf.end()) continue;
+            auto it = pathOf.find(dir->second + "/" + ev->name);
+            if (it != pathOf.end() && std::find(changed.begin(), changed.end(), it->second) == changed.end())
+                changed.push_back(it->second);
+        }
+    }
+    return changed;
+}
+
+#else
+
+FileWatcher::~FileWatcher() {}
+
+bool FileWatcher::watch(const std::string& path) {
+    std::error_code ec;
+    stamps[path] = std::filesystem::last_write_time(path, ec);
+    return !ec;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> changed;
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastCheck < std::chrono::milliseconds(500)) return changed;
+    lastCheck = now;
+    for (auto& entry : stamps) {
+        std::error_code ec;
+        auto t = std::filesystem::last_write_time(entry.first, ec);
+        if (!ec && t != entry.second) {
+            entry.second = t;
+            changed.push_back(entry.first);
+        }
+    }
+    return changed;
+}
+
+#endif
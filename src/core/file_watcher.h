@@ -0,0 +1,36 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <map>
+#include <string>
+#include <vector>
+#ifndef __linux__
+#include <chrono>
+#include <filesystem>
+#endif
+
+// Reports edits to a set of files without blocking. Uses inotify on Linux (watching
+// the parent directories, since editors often save by renaming a temp file over the
+// original); elsewhere it compares modification times at most twice a second.
+class FileWatcher {
+public:
+    FileWatcher() {}
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool watch(const std::string& path);
+    // Watched paths changed since the last call (each listed once)
+    std::vector<std::string> poll();
+private:
+#ifdef __linux__
+    int fd = -1;
+    std::map<int, std::string> dirOf;                 // inotify watch descriptor -> directory
+    std::map<std::string, std::string> pathOf;        // "dir/name" -> path as passed to watch()
+#else
+    std::map<std::string, std::filesystem::file_time_type> stamps;
+    std::chrono::steady_clock::time_point lastCheck;
+#endif
+};
+
+#endif // FILE_WATCHER_H
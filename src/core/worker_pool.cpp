@@ -0,0 +1,71 @@
+#include "worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned threadCount) {
+    for (unsigned i = 0; i < threadCount; i++) threads.emplace_back([this] { workerLoop(); });
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+WorkerPool& WorkerPool::shared() {
+    static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+bool WorkerPool::runOneJob(std::unique_lock<std::mutex>& lock) {
+    if (jobs.empty()) return false;
+    std::function<void()> job = std::move(jobs.front());
+    jobs.pop_front();
+    lock.unlock();
+    job();
+    lock.lock();
+    return true;
+}
+
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping && jobs.empty()) return;
+        runOneJob(lock);
+        jobDone.notify_all();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, size_t grain) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    // a few chunks per thread so uneven items still balance
+    size_t chunk = std::max(grain, (count + concurrency() * 4 - 1) / (concurrency() * 4));
+    size_t chunkCount = (count + chunk - 1) / chunk;
+    if (threads.empty() || chunkCount == 1) {
+        fn(0, count);
+        return;
+    }
+
+    size_t remaining = chunkCount; // guarded by mutex
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t c = 0; c < chunkCount; c++) {
+            size_t begin = c * chunk, end = std::min(count, begin + chunk);
+            jobs.emplace_back([&fn, &remaining, this, begin, end] {
+                fn(begin, end);
+                std::lock_guard<std::mutex> done(mutex);
+                remaining--;
+            });
+        }
+    }
+    jobReady.notify_all();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (remaining > 0) {
+        if (!runOneJob(lock)) jobDone.wait(lock, [&] { return remaining == 0 || !jobs.empty(); });
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small persistent thread pool for data-parallel loops (mesh generation, BVH
+// builds, light binning...). The calling thread helps run jobs while it waits,
+// so parallelFor may be nested and still works with zero worker threads.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threadCount);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Calls fn(begin, end) over [0, count) split into chunks of at least `grain` items
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, size_t grain = 1);
+
+    // Number of threads that run jobs, including the caller
+    unsigned concurrency() const { return (unsigned)threads.size() + 1; }
+
+    // Process-wide pool sized to the machine (hardware threads - 1 workers)
+    static WorkerPool& shared();
+private:
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    bool stopping = false;
+
+    void workerLoop();
+    bool runOneJob(std::unique_lock<std::mutex>& lock);
+};
+
+#endif // WORKER_POOL_H
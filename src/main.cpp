@@ -2,69 +2,24 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <string>
+#include <cstdio>
 #include "render/shader.h"
+#include "render/shader_variants.h"
+#include "render/program_cache.h"
 #include "render/camera.h"
+#include "core/file_watcher.h"
 #include "scene/city_scene.h"
 
-// Shaders (simple)
-const char* vertexSrc = R"glsl(
-#version 330 core
-layout(location=0) in vec3 aPos;
-layout(location=1) in vec3 aNormal;
-layout(location=2) in vec2 aUV;
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
-out vec3 vNormal;
-out vec3 vFragPos;
-out vec2 vUV;
-void main(){
-    vFragPos = vec3(model * vec4(aPos,1.0));
-    vNormal = mat3(transpose(inverse(model))) * aNormal;
-    vUV = aUV;
-    gl_Position = proj * view * vec4(vFragPos, 1.0);
-}
-)glsl";
-
-const char* fragmentSrc = R"glsl(
-#version 330 core
-in vec3 vNormal;
-in vec3 vFragPos;
-in vec2 vUV;
-out vec4 FragColor;
-uniform sampler2D tex;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-uniform vec3 baseColor;
-uniform float useTexture;
-uniform int texIndex;
-void main(){
-    vec3 N = normalize(vNormal);
-    vec3 L = normalize(lightPos - vFragPos);
-    float diff = max(dot(N,L), 0.0);
-    vec3 color = baseColor;
-    if (useTexture > 0.5) {
-        color = texture(tex, vUV).rgb;
-    }
-    
-    // Night lighting with lower ambient
-    vec3 ambient = 0.15 * color;
-    vec3 diffuse = diff * color * 0.6;
-    
-    // Subtle specular for natural materials
-    vec3 viewDir = normalize(viewPos - vFragPos);
-    vec3 H = normalize(L + viewDir);
-    float spec = pow(max(dot(N,H), 0.0), 16.0);
-    vec3 specular = vec3(0.2) * spec;
-    
-    vec3 result = ambient + diffuse + specular;
-    FragColor = vec4(result, 1.0);
-}
-)glsl";
+// Scene shader sources, loaded at startup and hot-reloaded when edited
+static const char* kSceneVertexPath = "assets/shaders/scene.vert";
+static const char* kSceneFragmentPath = "assets/shaders/scene.frag";
 
 static Camera camera;
 static bool rightMouseDown = false;
 static double lastX=0, lastY=0;
+static bool pickRequested = false; // left click, resolved in the main loop where the scene lives
+static double pickX=0, pickY=0;
+static bool toggleOcclusion = false;
 
 void cursor_cb(GLFWwindow* w, double xpos, double ypos) {
     if (!rightMouseDown) { lastX = xpos; lastY = ypos; return; }
@@ -77,6 +32,13 @@ void mouse_button_cb(GLFWwindow* w, int button, int action, int mods) {
     if (button == GLFW_MOUSE_BUTTON_RIGHT) {
         rightMouseDown = (action == GLFW_PRESS);
     }
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+        glfwGetCursorPos(w, &pickX, &pickY);
+        pickRequested = true;
+    }
+}
+void key_cb(GLFWwindow* w, int key, int scancode, int action, int mods) {
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) toggleOcclusion = true;
 }
 void scroll_cb(GLFWwindow* w, double x, double y) {
     camera.processScroll((float)y);
@@ -98,6 +60,7 @@ int main() {
     glfwSetCursorPosCallback(win, cursor_cb);
     glfwSetMouseButtonCallback(win, mouse_button_cb);
     glfwSetScrollCallback(win, scroll_cb);
+    glfwSetKeyCallback(win, key_cb);
 
     std::cout << "Initializing GLEW...\n";
     glewExperimental = GL_TRUE;
@@ -107,9 +70,20 @@ int main() {
     glEnable(GL_DEPTH_TEST);
 
     // Build shader
+    // submitted now, collected after scene setup: the driver compiles them in the
+    // background (concurrently with KHR_parallel_shader_compile) while the city is configured
     std::cout << "Building shaders...\n";
-    Shader shader(vertexSrc, fragmentSrc);
-    std::cout << "Shaders built successfully\n";
+    ProgramBinaryCache::shared().enable("shader_cache");
+    if (Shader::enableParallelCompile()) std::cout << "Parallel shader compilation enabled\n";
+    std::string vertexSrc, fragmentSrc;
+    if (!readShaderFile(kSceneVertexPath, vertexSrc) || !readShaderFile(kSceneFragmentPath, fragmentSrc)) {
+        std::cerr << "Shader sources missing (run from the project root)\n"; return -1;
+    }
+    ShaderVariants sceneShaders("scene", vertexSrc.c_str(), fragmentSrc.c_str());
+    sceneShaders.submit(CityScene::shaderVariants());
+    FileWatcher shaderWatcher;
+    shaderWatcher.watch(kSceneVertexPath);
+    shaderWatcher.watch(kSceneFragmentPath);
 
     // Get user input for city generation
     std::cout << "\n=== NIGHT CITYSCAPE GENERATOR ===\n";
@@ -201,6 +175,14 @@ int main() {
         std::cout << "Pond radius (2.0-15.0): ";
         std::cin >> pondRadius;
     } while (pondRadius < 2.0f || pondRadius > 15.0f);
+
+    int renderer;
+    do {
+        std::cout << "Renderer (1=Forward, 2=Deferred): ";
+        std::cin >> renderer;
+    } while (renderer < 1 || renderer > 2);
+    RenderPath renderPath = (renderer == 2) ? RENDER_DEFERRED : RENDER_FORWARD;
+    sceneShaders.submit(CityScene::shaderVariants(renderPath)); // the forward set is already compiling
     
     std::cout << "\nGenerating night city: " << cityName << "...\n";
     
@@ -209,7 +191,12 @@ int main() {
     if (!scene.init(citySize, numBuildings, buildingStyle, towerWidth, towerHeight, buildingWidth, buildingHeight, skyscraperWidth, skyscraperHeight, pondRadius, numSkyscrapers, numTowers, numOfficeBuildings)) { 
         std::cerr<<"Scene init failed\n"; return -1; 
     }
+    scene.setRenderPath(renderPath);
     std::cout << "Scene initialized successfully\n";
+    size_t stillCompiling = sceneShaders.poll();
+    if (stillCompiling) std::cout << "Waiting for " << stillCompiling << " shader variants...\n";
+    sceneShaders.finishAll();
+    std::cout << "Shaders built successfully (" << sceneShaders.size() << " variants)\n";
 
     // camera target at origin
     camera.target = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -219,8 +206,12 @@ int main() {
     std::cout << "\n=== CAMERA CONTROLS ===\n";
     std::cout << "Right-click + drag: Rotate camera\n";
     std::cout << "Mouse scroll: Zoom in/out\n";
+    std::cout << "Left-click: Select object\n";
+    std::cout << "O: Toggle occlusion culling\n";
     std::cout << "ESC: Exit\n\n";
 
+    double lastTitleUpdate = 0.0;
+    int framesSinceTitle = 0;
     while (!glfwWindowShouldClose(win)) {
         glfwPollEvents();
         
@@ -231,9 +222,57 @@ int main() {
         glClearColor(0.05f,0.05f,0.15f,1.0f); // Dark night sky
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        if (pickRequested) {
+            // cursor is in window coordinates, which can differ from the framebuffer on HiDPI
+            int winW, winH;
+            glfwGetWindowSize(win, &winW, &winH);
+            if (winW > 0 && winH > 0) {
+                float ndcX = (float)(2.0 * pickX / winW - 1.0);
+                float ndcY = (float)(1.0 - 2.0 * pickY / winH);
+                scene.pick(camera, ndcX, ndcY, (float)width / (float)height);
+            }
+            pickRequested = false;
+        }
+
+        if (toggleOcclusion) {
+            scene.setOcclusionCulling(!scene.occlusionCullingEnabled());
+            std::cout << "Occlusion culling " << (scene.occlusionCullingEnabled() ? "on" : "off") << "\n";
+            toggleOcclusion = false;
+        }
+
+        // shader hot reload: recompile (in the background, or a variant per frame without
+        // parallel compile), swap each variant in once linked
+        if (!shaderWatcher.poll().empty()) {
+            std::string vs, fs;
+            if (readShaderFile(kSceneVertexPath, vs) && readShaderFile(kSceneFragmentPath, fs)) {
+                std::cout << "Shader sources changed, recompiling...\n";
+                sceneShaders.reload(vs, fs);
+            }
+        }
+        sceneShaders.poll();
+
         camera.update(0.016f); // Keep for water animation
         scene.update(0.016f);
-        scene.render(shader, camera);
+        scene.render(sceneShaders, camera);
+
+        // culling stats and average frame time in the title bar, twice a second
+        framesSinceTitle++;
+        double now = glfwGetTime();
+        if (now - lastTitleUpdate > 0.5) {
+            const RenderStats& st = scene.stats();
+            char frameMs[32];
+            snprintf(frameMs, sizeof(frameMs), "%.2f ms", (now - lastTitleUpdate) * 1000.0 / framesSinceTitle);
+            std::string title = std::string("Night Cityscape Generator (") +
+                                (scene.getRenderPath() == RENDER_DEFERRED ? "deferred" : "forward") +
+                                ", " + frameMs + ") - visible " + std::to_string(st.visibleObjects) +
+                                " / culled " + std::to_string(st.culledObjects) +
+                                " / occluded " + std::to_string(st.occludedObjects) +
+                                " / impostors " + std::to_string(st.impostors) +
+                                " / shadow passes " + std::to_string(st.shadowCascadesDrawn);
+            glfwSetWindowTitle(win, title.c_str());
+            lastTitleUpdate = now;
+            framesSinceTitle = 0;
+        }
 
         glfwSwapBuffers(win);
     }
@@ -0,0 +1,129 @@
+#include "building_generator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Tiny deterministic generator so buildings can be built on any thread
+struct Rng {
+    unsigned int s;
+    explicit Rng(unsigned int seed) : s(seed * 2654435761u + 0x9e3779b9u) { if (!s) s = 1; }
+    float next() { // [0,1)
+        s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+        return (float)(s & 0xffffff) / 16777216.0f;
+    }
+    float range(float a, float b) { return a + (b - a) * next(); }
+};
+
+void addQuad(MeshData& d, const float p[4][3], float nx, float ny, float nz, const float uv[4][2]) {
+    unsigned int base = (unsigned int)d.vertexCount();
+    for (int k = 0; k < 4; k++) {
+        float v[8] = { p[k][0], p[k][1], p[k][2], nx, ny, nz, uv[k][0], uv[k][1] };
+        d.verts.insert(d.verts.end(), v, v + 8);
+    }
+    unsigned int q[6] = { 0,1,2, 0,2,3 };
+    for (unsigned int k : q) d.idx.push_back(base + k);
+}
+
+} // namespace
+
+// Axis-aligned box without a bottom face, wound CCW from outside. Side UVs are
+// tiled in world units; v uses absolute height so window rows line up across tiers.
+void appendFacadeBox(MeshData& d, float x0, float x1, float y0, float y1, float z0, float z1) {
+    float v0 = y0 / kFacadeTileH, v1 = y1 / kFacadeTileH;
+    float uX = std::max(1.0f, std::round((x1 - x0) / kFacadeTileW));
+    float uZ = std::max(1.0f, std::round((z1 - z0) / kFacadeTileW));
+    float uvX[4][2] = { {0,v0}, {uX,v0}, {uX,v1}, {0,v1} };
+    float uvZ[4][2] = { {0,v0}, {uZ,v0}, {uZ,v1}, {0,v1} };
+
+    float front[4][3] = { {x0,y0,z1}, {x1,y0,z1}, {x1,y1,z1}, {x0,y1,z1} };
+    float back[4][3]  = { {x1,y0,z0}, {x0,y0,z0}, {x0,y1,z0}, {x1,y1,z0} };
+    float right[4][3] = { {x1,y0,z1}, {x1,y0,z0}, {x1,y1,z0}, {x1,y1,z1} };
+    float left[4][3]  = { {x0,y0,z0}, {x0,y0,z1}, {x0,y1,z1}, {x0,y1,z0} };
+    float top[4][3]   = { {x0,y1,z1}, {x1,y1,z1}, {x1,y1,z0}, {x0,y1,z0} };
+    float uvTop[4][2] = { {0,0}, {1,0}, {1,1}, {0,1} };
+
+    addQuad(d, front, 0, 0, 1, uvX);
+    addQuad(d, back, 0, 0, -1, uvX);
+    addQuad(d, right, 1, 0, 0, uvZ);
+    addQuad(d, left, -1, 0, 0, uvZ);
+    addQuad(d, top, 0, 1, 0, uvTop);
+}
+
+namespace {
+
+void addCenteredBox(MeshData& d, float cx, float cz, float w, float dp, float y0, float y1) {
+    appendFacadeBox(d, cx - w*0.5f, cx + w*0.5f, y0, y1, cz - dp*0.5f, cz + dp*0.5f);
+}
+
+// Low wall around the edge of a roof
+void addParapet(MeshData& d, float cx, float cz, float w, float dp, float y, float h) {
+    float t = std::min(w, dp) * 0.06f;
+    float x0 = cx - w*0.5f, x1 = cx + w*0.5f, z0 = cz - dp*0.5f, z1 = cz + dp*0.5f;
+    appendFacadeBox(d, x0, x1, y, y + h, z1 - t, z1);
+    appendFacadeBox(d, x0, x1, y, y + h, z0, z0 + t);
+    appendFacadeBox(d, x0, x0 + t, y, y + h, z0 + t, z1 - t);
+    appendFacadeBox(d, x1 - t, x1, y, y + h, z0 + t, z1 - t);
+}
+
+} // namespace
+
+// Tier tops as fractions of the full height, and footprint scale per tier.
+// Consumes the first random draws, so it must run first on a fresh Rng.
+static int tierLayout(const BuildingParams& p, Rng& rng, float splits[3], float scales[3]) {
+    for (int t = 0; t < 3; t++) { splits[t] = 1.0f; scales[t] = 1.0f; }
+    if (p.type == 0) {          // skyscraper: two setbacks
+        splits[0] = rng.range(0.5f, 0.62f);
+        splits[1] = rng.range(0.78f, 0.88f);
+        scales[1] = rng.range(0.75f, 0.85f);
+        scales[2] = scales[1] * rng.range(0.7f, 0.8f);
+        return 3;
+    }
+    if (p.type == 1) {          // tower: one setback
+        splits[0] = rng.range(0.65f, 0.8f);
+        scales[1] = rng.range(0.7f, 0.8f);
+        return 2;
+    }
+    return 1;
+}
+
+float buildingBaseTop(const BuildingParams& p) {
+    Rng rng(p.seed);
+    float splits[3], scales[3];
+    tierLayout(p, rng, splits, scales);
+    return p.height * splits[0];
+}
+
+MeshData makeBuildingData(const BuildingParams& p) {
+    MeshData d;
+    Rng rng(p.seed);
+    float w = p.width, dp = p.depth, h = p.height;
+
+    float splits[3], scales[3];
+    int tiers = tierLayout(p, rng, splits, scales);
+
+    float y = 0.0f;
+    for (int t = 0; t < tiers; t++) {
+        float top = h * splits[t];
+        addCenteredBox(d, p.x, p.z, w * scales[t], dp * scales[t], y, top);
+        y = top;
+    }
+    float roofW = w * scales[tiers-1], roofD = dp * scales[tiers-1];
+
+    // roof details
+    addParapet(d, p.x, p.z, roofW, roofD, h, std::min(0.5f, h * 0.02f + 0.2f));
+    if (p.type == 0) {
+        addCenteredBox(d, p.x, p.z, roofW * 0.4f, roofD * 0.4f, h, h + 1.2f);
+        float spire = h * rng.range(0.08f, 0.15f);
+        addCenteredBox(d, p.x, p.z, 0.12f, 0.12f, h + 1.2f, h + 1.2f + spire);
+    } else {
+        int units = 1 + (int)(rng.next() * 3.0f);
+        for (int u = 0; u < units; u++) {
+            float ux = p.x + rng.range(-0.25f, 0.25f) * roofW;
+            float uz = p.z + rng.range(-0.25f, 0.25f) * roofD;
+            float us = rng.range(0.15f, 0.25f) * std::min(roofW, roofD);
+            addCenteredBox(d, ux, uz, us, us, h, h + rng.range(0.4f, 0.9f));
+        }
+    }
+    return d;
+}
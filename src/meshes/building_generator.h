@@ -0,0 +1,32 @@
+#ifndef BUILDING_GENERATOR_H
+#define BUILDING_GENERATOR_H
+
+#include "mesh_data.h"
+
+// Inputs for one procedural building (world space, y = 0 is the ground)
+struct BuildingParams {
+    float x = 0.0f, z = 0.0f;    // footprint center
+    float width = 1.0f;          // x extent of the base
+    float depth = 1.0f;          // z extent of the base
+    float height = 1.0f;
+    int type = 2;                // 0=skyscraper, 1=tower, 2=office
+    unsigned int seed = 0;       // drives setback heights and roof details
+};
+
+// World-space size of one facade texture tile
+const float kFacadeTileW = 2.0f;
+const float kFacadeTileH = 3.0f;
+
+// Builds a building as world-space geometry: stacked setback tiers, parapets and
+// rooftop units / spire. Facade UVs are tiled in world units (one tile per
+// kFacadeTileW x kFacadeTileH) so textures repeat per floor instead of stretching.
+MeshData makeBuildingData(const BuildingParams& p);
+
+// Top of the full-footprint base tier (below the first setback). The box from the
+// ground to this height is solid, so it can stand in for the building as an occluder.
+float buildingBaseTop(const BuildingParams& p);
+
+// Appends an axis-aligned box (no bottom face) with the same tiled facade UVs
+void appendFacadeBox(MeshData& d, float x0, float x1, float y0, float y1, float z0, float z1);
+
+#endif // BUILDING_GENERATOR_H
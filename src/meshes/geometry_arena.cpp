@@ -0,0 +1,61 @@
+#include "geometry_arena.h"
+#include <algorithm>
+
+GeometryArena::~GeometryArena() {
+    destroyMesh(gpu);
+}
+
+ArenaRange GeometryArena::reserve(size_t vertexCount, size_t indexCount) {
+    ArenaRange r;
+    r.baseVertex = (GLint)(verts.size() / kStrideFloats);
+    r.firstIndex = (GLsizei)idx.size();
+    r.indexCount = (GLsizei)indexCount;
+    r.vertexCount = (GLsizei)vertexCount;
+    verts.resize(verts.size() + vertexCount * kStrideFloats);
+    idx.resize(idx.size() + indexCount);
+    return r;
+}
+
+void GeometryArena::write(const ArenaRange& range, const MeshData& data, int chart) {
+    size_t in = (size_t)data.strideFloats;
+    size_t n = std::min(data.verts.size() / in, (size_t)range.vertexCount);
+    size_t count = std::min(data.idx.size(), (size_t)range.indexCount);
+    float* out = verts.data() + (size_t)range.baseVertex * kStrideFloats;
+    for (size_t v = 0; v < n; v++, out += kStrideFloats) {
+        std::copy_n(data.verts.begin() + v * in, 8, out);
+        out[8] = (float)chart;
+    }
+    std::copy_n(data.idx.begin(), count, idx.begin() + range.firstIndex);
+}
+
+void GeometryArena::upload() {
+    destroyMesh(gpu);
+    if (idx.empty()) return;
+    gpu = buildMesh(verts, idx, kStrideFloats);
+    glBindVertexArray(gpu.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, gpu.vbo);
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, kStrideFloats * sizeof(float), (void*)(8 * sizeof(float)));
+    glBindVertexArray(0);
+}
+
+void GeometryArena::clear() {
+    destroyMesh(gpu);
+    verts.clear();
+    idx.clear();
+}
+
+void GeometryArena::draw(const std::vector<ArenaRange>& ranges) const {
+    if (!gpu.vao || ranges.empty()) return;
+    drawCounts.clear(); drawOffsets.clear(); drawBases.clear();
+    for (auto& r : ranges) {
+        if (r.indexCount == 0) continue;
+        drawCounts.push_back(r.indexCount);
+        drawOffsets.push_back((const void*)((size_t)r.firstIndex * sizeof(unsigned int)));
+        drawBases.push_back(r.baseVertex);
+    }
+    glBindVertexArray(gpu.vao);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_INT,
+                                  drawOffsets.data(), (GLsizei)drawCounts.size(), drawBases.data());
+    glBindVertexArray(0);
+}
@@ -0,0 +1,50 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include "mesh.h"
+#include <vector>
+
+// Location of one mesh inside the arena's shared vertex/index buffers
+struct ArenaRange {
+    GLint baseVertex = 0;
+    GLsizei firstIndex = 0;
+    GLsizei indexCount = 0;
+    GLsizei vertexCount = 0;
+};
+
+// One VAO/VBO/EBO holding many meshes (the pos/normal/uv layout of buildMesh, plus a
+// per-mesh lightmap chart as attribute 7). Ranges are reserved serially, filled in
+// parallel (disjoint ranges only), uploaded once, and drawn together with a single
+// multi-draw call.
+class GeometryArena {
+public:
+    static const int kStrideFloats = 9;
+
+    GeometryArena() {}
+    ~GeometryArena();
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    ArenaRange reserve(size_t vertexCount, size_t indexCount);
+    // Copies data into a reserved range; indices stay local (baseVertex applies at draw time).
+    // chart is the mesh's lightmap facade chart + 1, or 0 for none (see Lightmap)
+    void write(const ArenaRange& range, const MeshData& data, int chart = 0);
+    void upload();
+    void clear();
+
+    // Draws the given ranges with one glMultiDrawElementsBaseVertex call
+    void draw(const std::vector<ArenaRange>& ranges) const;
+
+    size_t vertexCount() const { return verts.size() / kStrideFloats; }
+    size_t indexCount() const { return idx.size(); }
+private:
+    Mesh gpu;
+    std::vector<float> verts;
+    std::vector<unsigned int> idx;
+    // scratch for draw(), reused between frames
+    mutable std::vector<GLsizei> drawCounts;
+    mutable std::vector<const void*> drawOffsets;
+    mutable std::vector<GLint> drawBases;
+};
+
+#endif // GEOMETRY_ARENA_H
@@ -0,0 +1,256 @@
+#include "lod_builder.h"
+#include "building_generator.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <queue>
+
+namespace {
+
+// Symmetric 4x4 quadric stored as its 10 unique coefficients
+struct Quadric {
+    double a[10] = {0,0,0,0,0,0,0,0,0,0};
+    void addPlane(double nx, double ny, double nz, double d, double w) {
+        a[0] += w*nx*nx; a[1] += w*nx*ny; a[2] += w*nx*nz; a[3] += w*nx*d;
+        a[4] += w*ny*ny; a[5] += w*ny*nz; a[6] += w*ny*d;
+        a[7] += w*nz*nz; a[8] += w*nz*d;  a[9] += w*d*d;
+    }
+    void add(const Quadric& o) { for (int i = 0; i < 10; i++) a[i] += o.a[i]; }
+    double error(const std::array<float,3>& p) const {
+        double x = p[0], y = p[1], z = p[2];
+        return a[0]*x*x + 2*a[1]*x*y + 2*a[2]*x*z + 2*a[3]*x
+             + a[4]*y*y + 2*a[5]*y*z + 2*a[6]*y
+             + a[7]*z*z + 2*a[8]*z + a[9];
+    }
+};
+
+struct Collapse {
+    double cost;
+    int from, to;
+    unsigned int fromVersion, toVersion;
+    bool operator>(const Collapse& o) const { return cost > o.cost; }
+};
+
+std::array<double,3> triNormal(const std::array<float,3>& a, const std::array<float,3>& b, const std::array<float,3>& c) {
+    double e1[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+    double e2[3] = { c[0]-a[0], c[1]-a[1], c[2]-a[2] };
+    return { e1[1]*e2[2]-e1[2]*e2[1], e1[2]*e2[0]-e1[0]*e2[2], e1[0]*e2[1]-e1[1]*e2[0] };
+}
+
+} // namespace
+
+MeshData simplifyMesh(const MeshData& mesh, size_t targetTriangles) {
+    const int stride = mesh.strideFloats;
+    size_t vertexCount = mesh.vertexCount();
+    size_t triCount = mesh.triangleCount();
+    if (triCount <= targetTriangles || stride < 3) return mesh;
+
+    // weld split vertices by position
+    std::map<std::array<float,3>, int> weldMap;
+    std::vector<int> weld(vertexCount);
+    std::vector<std::array<float,3>> pos;
+    for (size_t v = 0; v < vertexCount; v++) {
+        const float* p = &mesh.verts[v * stride];
+        std::array<float,3> key = { p[0], p[1], p[2] };
+        auto it = weldMap.find(key);
+        if (it == weldMap.end()) {
+            it = weldMap.emplace(key, (int)pos.size()).first;
+            pos.push_back(key);
+        }
+        weld[v] = it->second;
+    }
+    size_t posCount = pos.size();
+
+    std::vector<std::array<int,3>> tris(triCount);
+    std::vector<char> alive(triCount, 1);
+    std::vector<std::vector<int>> vertTris(posCount);
+    std::vector<Quadric> quadrics(posCount);
+    std::map<std::pair<int,int>, int> edgeUse; // undirected edge -> triangle count
+
+    size_t liveTris = 0;
+    for (size_t t = 0; t < triCount; t++) {
+        for (int k = 0; k < 3; k++) tris[t][k] = weld[mesh.idx[t*3 + k]];
+        if (tris[t][0] == tris[t][1] || tris[t][1] == tris[t][2] || tris[t][0] == tris[t][2]) { alive[t] = 0; continue; }
+        liveTris++;
+        auto n = triNormal(pos[tris[t][0]], pos[tris[t][1]], pos[tris[t][2]]);
+        double len = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        if (len > 0.0) {
+            double nx = n[0]/len, ny = n[1]/len, nz = n[2]/len;
+            const auto& p0 = pos[tris[t][0]];
+            double d = -(nx*p0[0] + ny*p0[1] + nz*p0[2]);
+            for (int k = 0; k < 3; k++) quadrics[tris[t][k]].addPlane(nx, ny, nz, d, len * 0.5);
+        }
+        for (int k = 0; k < 3; k++) {
+            vertTris[tris[t][k]].push_back((int)t);
+            int a = tris[t][k], b = tris[t][(k+1)%3];
+            edgeUse[{std::min(a,b), std::max(a,b)}]++;
+        }
+    }
+
+    // boundary edges get a perpendicular constraint plane so open edges do not shrink
+    for (size_t t = 0; t < triCount; t++) {
+        if (!alive[t]) continue;
+        auto n = triNormal(pos[tris[t][0]], pos[tris[t][1]], pos[tris[t][2]]);
+        for (int k = 0; k < 3; k++) {
+            int a = tris[t][k], b = tris[t][(k+1)%3];
+            if (edgeUse[{std::min(a,b), std::max(a,b)}] != 1) continue;
+            double e[3] = { pos[b][0]-pos[a][0], pos[b][1]-pos[a][1], pos[b][2]-pos[a][2] };
+            double c[3] = { e[1]*n[2]-e[2]*n[1], e[2]*n[0]-e[0]*n[2], e[0]*n[1]-e[1]*n[0] };
+            double len = std::sqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]);
+            if (len <= 0.0) continue;
+            for (double& x : c) x /= len;
+            double d = -(c[0]*pos[a][0] + c[1]*pos[a][1] + c[2]*pos[a][2]);
+            double w = std::sqrt(e[0]*e[0] + e[1]*e[1] + e[2]*e[2]) * 10.0;
+            quadrics[a].addPlane(c[0], c[1], c[2], d, w);
+            quadrics[b].addPlane(c[0], c[1], c[2], d, w);
+        }
+    }
+
+    std::vector<unsigned int> version(posCount, 0);
+    std::vector<int> collapsedTo(posCount, -1);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+    auto pushEdge = [&](int a, int b) {
+        Quadric q = quadrics[a];
+        q.add(quadrics[b]);
+        double ea = q.error(pos[a]), eb = q.error(pos[b]);
+        // collapse onto the endpoint with less error (keeps original uv/normal valid)
+        if (ea < eb) heap.push({ea, b, a, version[b], version[a]});
+        else         heap.push({eb, a, b, version[a], version[b]});
+    };
+    for (auto& e : edgeUse) pushEdge(e.first.first, e.first.second);
+
+    // would moving `from` onto `to` flip or degenerate any surviving triangle?
+    auto flips = [&](int from, int to) {
+        for (int t : vertTris[from]) {
+            if (!alive[t]) continue;
+            auto& tri = tris[t];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) continue; // removed by the collapse
+            std::array<float,3> p[3];
+            for (int k = 0; k < 3; k++) p[k] = pos[tri[k] == from ? to : tri[k]];
+            auto before = triNormal(pos[tri[0]], pos[tri[1]], pos[tri[2]]);
+            auto after = triNormal(p[0], p[1], p[2]);
+            double dot = before[0]*after[0] + before[1]*after[1] + before[2]*after[2];
+            double lb = std::sqrt(before[0]*before[0] + before[1]*before[1] + before[2]*before[2]);
+            double la = std::sqrt(after[0]*after[0] + after[1]*after[1] + after[2]*after[2]);
+            if (la < 1e-9 || dot < 0.5 * lb * la) return true;
+        }
+        return false;
+    };
+
+    while (liveTris > targetTriangles && !heap.empty()) {
+        Collapse c = heap.top();
+        heap.pop();
+        if (collapsedTo[c.from] >= 0 || collapsedTo[c.to] >= 0) continue;
+        if (version[c.from] != c.fromVersion || version[c.to] != c.toVersion) continue;
+        if (flips(c.from, c.to)) continue;
+
+        for (int t : vertTris[c.from]) {
+            if (!alive[t]) continue;
+            auto& tri = tris[t];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                alive[t] = 0;
+                liveTris--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++) if (tri[k] == c.from) tri[k] = c.to;
+            vertTris[c.to].push_back(t);
+        }
+        vertTris[c.from].clear();
+        collapsedTo[c.from] = c.to;
+        quadrics[c.to].add(quadrics[c.from]);
+        version[c.to]++;
+
+        // requeue edges around the surviving vertex
+        std::vector<int> neighbours;
+        for (int t : vertTris[c.to]) {
+            if (!alive[t]) continue;
+            for (int k = 0; k < 3; k++) if (tris[t][k] != c.to) neighbours.push_back(tris[t][k]);
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (int n : neighbours) pushEdge(c.to, n);
+    }
+
+    auto resolve = [&](int w) { while (collapsedTo[w] >= 0) w = collapsedTo[w]; return w; };
+
+    // original vertices per welded position, to find uvs for corners that moved
+    std::vector<std::vector<unsigned int>> atPos(posCount);
+    for (size_t v = 0; v < vertexCount; v++) atPos[weld[v]].push_back((unsigned int)v);
+
+    // emit surviving triangles; each corner keeps its original normal, and a corner that
+    // moved takes the uv of an original vertex of the same face (same normal) at its new
+    // position, so the texture does not stretch along the collapsed edge. Without such
+    // a vertex it keeps its own uv.
+    MeshData out;
+    out.strideFloats = stride;
+    std::vector<int> remap(vertexCount, -1);
+    for (size_t t = 0; t < triCount; t++) {
+        if (!alive[t]) continue;
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = mesh.idx[t*3 + k];
+            if (remap[v] < 0) {
+                remap[v] = (int)out.vertexCount();
+                const float* src = &mesh.verts[(size_t)v * stride];
+                out.verts.insert(out.verts.end(), src, src + stride);
+                int target = resolve(weld[v]);
+                const auto& p = pos[target];
+                float* dst = &out.verts[(size_t)remap[v] * stride];
+                dst[0] = p[0]; dst[1] = p[1]; dst[2] = p[2];
+                if (target != weld[v] && stride >= 8) {
+                    for (unsigned int u : atPos[target]) {
+                        const float* o = &mesh.verts[(size_t)u * stride];
+                        if (o[3]*src[3] + o[4]*src[4] + o[5]*src[5] < 0.999f) continue;
+                        dst[6] = o[6]; dst[7] = o[7];
+                        break;
+                    }
+                }
+            }
+            out.idx.push_back((unsigned int)remap[v]);
+        }
+    }
+    return out;
+}
+
+MeshData makeBoundsBox(const MeshData& mesh, float maxTop) {
+    MeshData out;
+    size_t n = mesh.vertexCount();
+    if (n == 0) return out;
+    float lo[3] = { 1e30f, 1e30f, 1e30f }, hi[3] = { -1e30f, -1e30f, -1e30f };
+    for (size_t v = 0; v < n; v++) {
+        const float* p = &mesh.verts[v * mesh.strideFloats];
+        for (int k = 0; k < 3; k++) { lo[k] = std::min(lo[k], p[k]); hi[k] = std::max(hi[k], p[k]); }
+    }
+    appendFacadeBox(out, lo[0], hi[0], lo[1], std::max(lo[1], std::min(hi[1], maxTop)), lo[2], hi[2]);
+    return out;
+}
+
+std::vector<MeshData> buildLodChain(const MeshData& base, float boxTop) {
+    std::vector<MeshData> chain;
+    chain.push_back(base);
+    const float ratios[] = { 0.5f, 0.2f };
+    for (float r : ratios) {
+        size_t target = std::max<size_t>(12, (size_t)(base.triangleCount() * r));
+        MeshData lod = simplifyMesh(chain.back(), target);
+        if (lod.triangleCount() < chain.back().triangleCount()) chain.push_back(std::move(lod));
+    }
+    MeshData box = makeBoundsBox(base, boxTop);
+    if (box.triangleCount() < chain.back().triangleCount()) chain.push_back(std::move(box));
+    return chain;
+}
+
+int selectLod(float projectedSize, int currentLod, int lodCount, float hysteresis) {
+    // switch to level i+1 once the object covers less than thresholds[i] of the screen height
+    static const float thresholds[kMaxLods - 1] = { 0.30f, 0.12f, 0.05f };
+    int lod = 0;
+    while (lod < lodCount - 1 && lod < kMaxLods - 1) {
+        float t = thresholds[lod];
+        // stay finer a little longer if we are already finer, and vice versa
+        if (lod < currentLod) t *= (1.0f + hysteresis);
+        else t *= (1.0f - hysteresis);
+        if (projectedSize >= t) break;
+        lod++;
+    }
+    return lod;
+}
@@ -0,0 +1,31 @@
+#ifndef LOD_BUILDER_H
+#define LOD_BUILDER_H
+
+#include "mesh_data.h"
+#include <vector>
+
+const int kMaxLods = 4;
+
+// Quadric error metric edge-collapse simplification (Garland & Heckbert).
+// Vertices are welded by position first so flat-shaded meshes simplify as one
+// surface; each output vertex keeps its original normal, and one that moved takes the
+// uv of a same-normal vertex at its new position. Collapses that would flip a triangle
+// are rejected, so the result may stop above the target.
+MeshData simplifyMesh(const MeshData& mesh, size_t targetTriangles);
+
+// Axis-aligned bounding box of the mesh as a single facade box (coarsest LOD). The top
+// is capped at maxTop, so thin details above the body (spires, rooftop units) do not
+// turn into a solid block.
+MeshData makeBoundsBox(const MeshData& mesh, float maxTop = 1e30f);
+
+// LOD 0 = input, then QEM at 50% and 20% of the triangles, then the bounds box up to boxTop.
+// Levels that fail to get smaller are skipped, so the chain may be shorter than kMaxLods.
+std::vector<MeshData> buildLodChain(const MeshData& base, float boxTop = 1e30f);
+
+// Picks a LOD from the object's projected size (bounding sphere diameter / screen
+// height). Thresholds are the sizes below which each next-coarser level is used;
+// `hysteresis` widens the band around the current level so objects near a
+// threshold do not flicker between levels while the camera moves.
+int selectLod(float projectedSize, int currentLod, int lodCount, float hysteresis = 0.15f);
+
+#endif // LOD_BUILDER_H
@@ -1,9 +1,10 @@
 #include "mesh.h"
+#include "mesh_optimizer.h"
 #include <cmath>
 #include <vector>
 
 // Helper to create VAO from vertex buffer and index buffer
-static Mesh buildMesh(const std::vector<float>& verts, const std::vector<unsigned int>& idx, int strideFloats=8) {
+Mesh buildMesh(const std::vector<float>& verts, const std::vector<unsigned int>& idx, int strideFloats) {
     Mesh m;
     glGenVertexArrays(1, &m.vao);
     glGenBuffers(1, &m.vbo);
@@ -27,6 +28,17 @@ static Mesh buildMesh(const std::vector<float>& verts, const std::vector<unsigne
     return m;
 }
 
+Mesh buildMesh(const MeshData& data) {
+    return buildMesh(data.verts, data.idx, data.strideFloats);
+}
+
+void destroyMesh(Mesh& m) {
+    if (m.vao) glDeleteVertexArrays(1, &m.vao);
+    if (m.vbo) glDeleteBuffers(1, &m.vbo);
+    if (m.ebo) glDeleteBuffers(1, &m.ebo);
+    m = Mesh();
+}
+
 Mesh makeCube() {
     // 24 vertices (6 faces * 4), each vertex: pos(3) normal(3) uv(2) => 8 floats
     float V[] = {
@@ -87,10 +99,11 @@ Mesh makeQuadXZ() {
     return buildMesh(verts, indices, 8);
 }
 
-Mesh makeCircleFan(float cx, float cz, float radius, int segments) {
+MeshData makeCircleFanData(float cx, float cz, float radius, int segments) {
     // center + ring points
-    std::vector<float> verts;
-    std::vector<unsigned int> idx;
+    MeshData data;
+    std::vector<float>& verts = data.verts;
+    std::vector<unsigned int>& idx = data.idx;
     verts.reserve((segments+2)*8);
     // center
     verts.push_back(cx); verts.push_back(0.01f); verts.push_back(cz);
@@ -111,5 +124,48 @@ Mesh makeCircleFan(float cx, float cz, float radius, int segments) {
         idx.push_back(i);
         idx.push_back(i+1);
     }
-    return buildMesh(verts, idx, 8);
+    return data;
+}
+
+MeshData makeDiscData(int rings, int segments) {
+    MeshData data;
+    std::vector<float>& verts = data.verts;
+    std::vector<unsigned int>& idx = data.idx;
+    verts.reserve((1 + rings * (segments + 1)) * 8);
+    float center[8] = { 0.0f, kWaterLevel, 0.0f, 0, 1, 0, 0.5f, 0.5f };
+    verts.insert(verts.end(), center, center + 8);
+    for (int r = 1; r <= rings; r++) {
+        float radius = (float)r / rings;
+        for (int i = 0; i <= segments; i++) {
+            float a = (float)i * 2.0f * 3.14159265f / segments;
+            float x = radius * cosf(a), z = radius * sinf(a);
+            float v[8] = { x, kWaterLevel, z, 0, 1, 0, (x + 1.0f) * 0.5f, (z + 1.0f) * 0.5f };
+            verts.insert(verts.end(), v, v + 8);
+        }
+    }
+    // ring r starts at vertex 1 + (r-1)(segments+1); the center fans out to ring 1
+    for (int i = 0; i < segments; i++) {
+        idx.push_back(0); idx.push_back(i + 2); idx.push_back(i + 1);
+    }
+    for (int r = 1; r < rings; r++) {
+        unsigned inner = 1 + (r - 1) * (segments + 1), outer = inner + segments + 1;
+        for (int i = 0; i < segments; i++) {
+            unsigned a = inner + i, b = inner + i + 1, c = outer + i, d = outer + i + 1;
+            idx.push_back(a); idx.push_back(b); idx.push_back(c);
+            idx.push_back(b); idx.push_back(d); idx.push_back(c);
+        }
+    }
+    return data;
+}
+
+Mesh makeDisc(int rings, int segments) {
+    MeshData data = makeDiscData(rings, segments);
+    optimizeMesh(data);
+    return buildMesh(data);
+}
+
+Mesh makeCircleFan(float cx, float cz, float radius, int segments) {
+    MeshData data = makeCircleFanData(cx, cz, radius, segments);
+    optimizeMesh(data);
+    return buildMesh(data);
 }
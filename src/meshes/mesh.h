@@ -3,6 +3,7 @@
 
 #include <GL/glew.h>
 #include <vector>
+#include "mesh_data.h"
 
 // Simple mesh container
 struct Mesh {
@@ -12,9 +13,24 @@ struct Mesh {
     GLsizei elemCount = 0;
 };
 
+// Uploads interleaved pos(3) normal(3) uv(2) vertices + indices into a new VAO
+Mesh buildMesh(const std::vector<float>& verts, const std::vector<unsigned int>& idx, int strideFloats = 8);
+Mesh buildMesh(const MeshData& data);
+
+// Frees the VAO/VBO/EBO of a mesh and resets it
+void destroyMesh(Mesh& m);
+
 // Builders:
 Mesh makeCube();        // unit cube centered at origin (with normals + uv)
 Mesh makeQuadXZ();     // unit quad on XZ plane (y=0) (unit square)
 Mesh makeCircleFan(float cx, float cz, float radius, int segments = 48);
+Mesh makeDisc(int rings, int segments); // unit disc at the origin, see makeDiscData
+
+// CPU-side generators (used by the builders above, the optimizer and benchmarks)
+MeshData makeCircleFanData(float cx, float cz, float radius, int segments = 48);
+// Unit disc (y = kWaterLevel) tessellated into `rings` concentric rings of `segments`
+// quads, so a vertex shader has enough vertices to displace
+MeshData makeDiscData(int rings, int segments);
+const float kWaterLevel = 0.05f;
 
 #endif // MESH_H
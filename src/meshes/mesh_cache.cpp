@@ -0,0 +1,64 @@
+#include "mesh_cache.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+MeshCache::~MeshCache() {
+    for (auto& e : entries) destroyMesh(e.second.mesh);
+    entries.clear();
+}
+
+const Mesh& MeshCache::acquire(const MeshKey& key, const std::function<Mesh()>& build) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        it = entries.emplace(key, Entry()).first;
+        it->second.mesh = build();
+    }
+    it->second.refs++;
+    return it->second.mesh;
+}
+
+MeshHandle MeshCache::cube() {
+    MeshHandle h;
+    h.key = {MeshGen::Cube, 0};
+    h.mesh = acquire(h.key, [] { return makeCube(); });
+    return h;
+}
+
+MeshHandle MeshCache::quadXZ() {
+    MeshHandle h;
+    h.key = {MeshGen::QuadXZ, 0};
+    h.mesh = acquire(h.key, [] { return makeQuadXZ(); });
+    return h;
+}
+
+MeshHandle MeshCache::circleFan(float cx, float cz, float radius, int segments) {
+    MeshHandle h;
+    h.key = {MeshGen::CircleFan, segments};
+    h.mesh = acquire(h.key, [segments] { return makeCircleFan(0.0f, 0.0f, 1.0f, segments); });
+    h.transform = glm::translate(glm::mat4(1.0f), glm::vec3(cx, 0.0f, cz));
+    h.transform = glm::scale(h.transform, glm::vec3(radius, 1.0f, radius));
+    return h;
+}
+
+MeshHandle MeshCache::disc(float cx, float cz, float radius, int rings, int segments) {
+    MeshHandle h;
+    h.key = {MeshGen::Disc, rings << 16 | segments};
+    h.mesh = acquire(h.key, [rings, segments] { return makeDisc(rings, segments); });
+    h.transform = glm::translate(glm::mat4(1.0f), glm::vec3(cx, 0.0f, cz));
+    h.transform = glm::scale(h.transform, glm::vec3(radius, 1.0f, radius));
+    return h;
+}
+
+void MeshCache::release(MeshHandle& h) {
+    if (!h.valid()) return;
+    auto it = entries.find(h.key);
+    if (it != entries.end() && --it->second.refs <= 0) {
+        destroyMesh(it->second.mesh);
+        entries.erase(it);
+    }
+    h = MeshHandle();
+}
+
+int MeshCache::refCount(const MeshKey& key) const {
+    auto it = entries.find(key);
+    return it == entries.end() ? 0 : it->second.refs;
+}
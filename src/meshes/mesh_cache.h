@@ -0,0 +1,55 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "mesh.h"
+#include <glm/glm.hpp>
+#include <functional>
+#include <map>
+
+// Procedural generators the cache knows how to canonicalize
+enum class MeshGen { Cube, QuadXZ, CircleFan, Disc };
+
+// Identifies a canonical (unit/local space) mesh: generator + shape parameters.
+// Placement parameters (center, radius) are not part of the key; they go into the transform.
+struct MeshKey {
+    MeshGen gen;
+    int param = 0; // e.g. segment count for CircleFan, rings << 16 | segments for Disc
+    bool operator<(const MeshKey& o) const {
+        return gen != o.gen ? gen < o.gen : param < o.param;
+    }
+};
+
+// Shared mesh plus the model transform that places the canonical shape
+struct MeshHandle {
+    MeshKey key{MeshGen::Cube, 0};
+    Mesh mesh;
+    glm::mat4 transform = glm::mat4(1.0f);
+    bool valid() const { return mesh.vao != 0; }
+};
+
+// Builds and uploads each canonical mesh once and reference-counts the GPU buffers.
+// Every acquire (cube/quadXZ/circleFan) must be paired with a release.
+class MeshCache {
+public:
+    MeshCache() {}
+    ~MeshCache();
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    MeshHandle cube();
+    MeshHandle quadXZ();
+    // Unit-radius fan at the origin, placed at (cx, 0, cz) and scaled by radius
+    MeshHandle circleFan(float cx, float cz, float radius, int segments = 48);
+    // Tessellated unit disc (water surfaces), placed like circleFan
+    MeshHandle disc(float cx, float cz, float radius, int rings = 24, int segments = 96);
+
+    void release(MeshHandle& h);
+    size_t size() const { return entries.size(); }
+    int refCount(const MeshKey& key) const;
+private:
+    struct Entry { Mesh mesh; int refs = 0; };
+    std::map<MeshKey, Entry> entries;
+    const Mesh& acquire(const MeshKey& key, const std::function<Mesh()>& build);
+};
+
+#endif // MESH_CACHE_H
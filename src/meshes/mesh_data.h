@@ -0,0 +1,17 @@
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include <cstddef>
+#include <vector>
+
+// CPU-side geometry before upload: interleaved pos(3) normal(3) uv(2) + triangle list
+struct MeshData {
+    std::vector<float> verts;
+    std::vector<unsigned int> idx;
+    int strideFloats = 8;
+
+    size_t vertexCount() const { return strideFloats ? verts.size() / strideFloats : 0; }
+    size_t triangleCount() const { return idx.size() / 3; }
+};
+
+#endif // MESH_DATA_H
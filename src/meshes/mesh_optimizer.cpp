@@ -0,0 +1,241 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <array>
+
+namespace {
+
+const int kCacheSize = 32;
+const float kCacheDecayPower = 1.5f;
+const float kLastTriScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+float vertexScore(int cachePos, int remainingTris) {
+    if (remainingTris == 0) return -1.0f;
+    float score = 0.0f;
+    if (cachePos >= 0) {
+        if (cachePos < 3) {
+            // the three vertices of the last triangle get a fixed score so the
+            // next triangle does not simply reuse the same edge
+            score = kLastTriScore;
+        } else {
+            float s = 1.0f - (float)(cachePos - 3) / (float)(kCacheSize - 3);
+            score = powf(s, kCacheDecayPower);
+        }
+    }
+    score += kValenceBoostScale * powf((float)remainingTris, -kValenceBoostPower);
+    return score;
+}
+
+// Simulates a FIFO cache, returning per-triangle miss counts
+std::vector<int> triangleMisses(const std::vector<unsigned int>& idx, size_t vertexCount, int cacheSize) {
+    std::vector<int> stamp(vertexCount, -(1 << 30));
+    std::vector<int> misses(idx.size() / 3, 0);
+    int time = 0;
+    for (size_t t = 0; t < idx.size() / 3; t++) {
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = idx[t*3 + k];
+            if (time - stamp[v] > cacheSize) {
+                stamp[v] = time++;
+                misses[t]++;
+            }
+        }
+    }
+    return misses;
+}
+
+} // namespace
+
+void optimizeVertexCache(std::vector<unsigned int>& idx, size_t vertexCount) {
+    size_t triCount = idx.size() / 3;
+    if (triCount == 0) return;
+
+    // vertex -> triangle adjacency (CSR layout)
+    std::vector<int> remaining(vertexCount, 0);
+    for (unsigned int v : idx) remaining[v]++;
+    std::vector<int> offset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) offset[v+1] = offset[v] + remaining[v];
+    std::vector<int> adjacency(idx.size());
+    std::vector<int> fill(offset.begin(), offset.end() - 1);
+    for (size_t t = 0; t < triCount; t++)
+        for (int k = 0; k < 3; k++) adjacency[fill[idx[t*3 + k]]++] = (int)t;
+
+    // Triangle scores are only read for candidates, i.e. triangles touching the cache,
+    // and those are all rescored after every emit. Triangles left behind by evicted
+    // vertices keep stale scores, but they are never candidates until a vertex of
+    // theirs re-enters the cache (and gets rescored then).
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) vScore[v] = vertexScore(-1, remaining[v]);
+    std::vector<float> tScore(triCount, 0.0f);
+    std::vector<char> emitted(triCount, 0);
+
+    std::vector<unsigned int> out;
+    out.reserve(idx.size());
+    std::vector<unsigned int> cache, newCache;
+    size_t scanCursor = 0;
+    int best = -1;
+
+    while (out.size() < idx.size()) {
+        if (best < 0) {
+            // nothing adjacent to the cache: restart at the next triangle not yet emitted, in
+            // input order; the cursor only moves forward, so all restarts cost O(n) together
+            while (scanCursor < triCount && emitted[scanCursor]) scanCursor++;
+            if (scanCursor == triCount) break;
+            best = (int)scanCursor;
+        }
+
+        emitted[best] = 1;
+        newCache.clear();
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = idx[best*3 + k];
+            out.push_back(v);
+            newCache.push_back(v);
+            // drop the triangle from the vertex's remaining adjacency
+            int* first = &adjacency[offset[v]];
+            int* last = first + remaining[v];
+            int* it = std::find(first, last, best);
+            if (it != last) { *it = *(last - 1); remaining[v]--; }
+        }
+        for (unsigned int v : cache)
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) newCache.push_back(v);
+
+        // vertices pushed past the cache end get their position reset
+        for (size_t i = kCacheSize; i < newCache.size(); i++) {
+            cachePos[newCache[i]] = -1;
+            vScore[newCache[i]] = vertexScore(-1, remaining[newCache[i]]);
+        }
+        if (newCache.size() > (size_t)kCacheSize) newCache.resize(kCacheSize);
+        cache.swap(newCache);
+
+        for (size_t i = 0; i < cache.size(); i++) {
+            unsigned int v = cache[i];
+            cachePos[v] = (int)i;
+            vScore[v] = vertexScore((int)i, remaining[v]);
+        }
+
+        // rescore the triangles touching the cache and pick the best one
+        best = -1;
+        float bestScore = -1e30f;
+        for (unsigned int v : cache) {
+            for (int a = offset[v]; a < offset[v] + remaining[v]; a++) {
+                int t = adjacency[a];
+                tScore[t] = vScore[idx[t*3]] + vScore[idx[t*3+1]] + vScore[idx[t*3+2]];
+                if (tScore[t] > bestScore) { bestScore = tScore[t]; best = t; }
+            }
+        }
+    }
+    idx.swap(out);
+}
+
+void optimizeOverdraw(std::vector<unsigned int>& idx, const MeshData& data, float threshold) {
+    size_t triCount = idx.size() / 3;
+    size_t vertexCount = data.vertexCount();
+    if (triCount < 2 || data.strideFloats < 3) return;
+
+    // cluster boundaries: hard where a triangle misses all 3 vertices (the cache is
+    // cold there anyway), soft where the cluster-so-far ACMR is within threshold
+    const int cacheSize = 16;
+    std::vector<int> misses = triangleMisses(idx, vertexCount, cacheSize);
+    int totalMisses = 0;
+    for (int m : misses) totalMisses += m;
+    float meshACMR = (float)totalMisses / (float)triCount;
+
+    std::vector<size_t> clusters; // start triangle of each cluster
+    clusters.push_back(0);
+    int clusterMisses = 0;
+    size_t clusterStart = 0;
+    for (size_t t = 0; t < triCount; t++) {
+        if (t > clusterStart) {
+            float clusterACMR = (float)clusterMisses / (float)(t - clusterStart);
+            bool hard = misses[t] == 3;
+            bool soft = t - clusterStart >= 8 && clusterACMR <= meshACMR * threshold;
+            if (hard || soft) {
+                clusters.push_back(t);
+                clusterStart = t;
+                clusterMisses = 0;
+            }
+        }
+        clusterMisses += misses[t];
+    }
+    if (clusters.size() < 2) return;
+    clusters.push_back(triCount);
+
+    auto pos = [&](unsigned int v) {
+        const float* p = &data.verts[(size_t)v * data.strideFloats];
+        return std::array<float,3>{p[0], p[1], p[2]};
+    };
+
+    // mesh centroid (vertex average is enough for the sort key)
+    float mc[3] = {0, 0, 0};
+    for (size_t v = 0; v < vertexCount; v++) {
+        auto p = pos((unsigned int)v);
+        for (int k = 0; k < 3; k++) mc[k] += p[k];
+    }
+    for (int k = 0; k < 3; k++) mc[k] /= (float)vertexCount;
+
+    // score = how much each cluster faces away from the mesh center
+    struct Cluster { size_t begin, end; float score; };
+    std::vector<Cluster> order;
+    for (size_t c = 0; c + 1 < clusters.size(); c++) {
+        float cen[3] = {0, 0, 0}, nrm[3] = {0, 0, 0}, area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c+1]; t++) {
+            auto a = pos(idx[t*3]), b = pos(idx[t*3+1]), d = pos(idx[t*3+2]);
+            float e1[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+            float e2[3] = {d[0]-a[0], d[1]-a[1], d[2]-a[2]};
+            float n[3] = {e1[1]*e2[2]-e1[2]*e2[1], e1[2]*e2[0]-e1[0]*e2[2], e1[0]*e2[1]-e1[1]*e2[0]};
+            float w = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+            for (int k = 0; k < 3; k++) {
+                cen[k] += (a[k] + b[k] + d[k]) / 3.0f * w;
+                nrm[k] += n[k];
+            }
+            area += w;
+        }
+        float score = 0.0f;
+        float nl = sqrtf(nrm[0]*nrm[0] + nrm[1]*nrm[1] + nrm[2]*nrm[2]);
+        if (area > 0.0f && nl > 0.0f) {
+            for (int k = 0; k < 3; k++) score += (cen[k] / area - mc[k]) * (nrm[k] / nl);
+        }
+        order.push_back({clusters[c], clusters[c+1], score});
+    }
+    std::stable_sort(order.begin(), order.end(), [](const Cluster& a, const Cluster& b) { return a.score > b.score; });
+
+    std::vector<unsigned int> out;
+    out.reserve(idx.size());
+    for (auto& c : order) out.insert(out.end(), idx.begin() + c.begin*3, idx.begin() + c.end*3);
+
+    // every split costs the edge shared across it; keep the cache order if that got too expensive
+    if (computeACMR(out, vertexCount, cacheSize) <= meshACMR * threshold) idx.swap(out);
+}
+
+void optimizeVertexFetch(MeshData& data) {
+    size_t vertexCount = data.vertexCount();
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    unsigned int next = 0;
+    for (auto& v : data.idx) {
+        if (remap[v] == unused) remap[v] = next++;
+        v = remap[v];
+    }
+    std::vector<float> verts((size_t)next * data.strideFloats);
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (remap[v] == unused) continue;
+        std::copy_n(&data.verts[v * data.strideFloats], data.strideFloats, &verts[(size_t)remap[v] * data.strideFloats]);
+    }
+    data.verts.swap(verts);
+}
+
+void optimizeMesh(MeshData& data) {
+    optimizeVertexCache(data.idx, data.vertexCount());
+    optimizeOverdraw(data.idx, data);
+    optimizeVertexFetch(data);
+}
+
+float computeACMR(const std::vector<unsigned int>& idx, size_t vertexCount, int cacheSize) {
+    if (idx.size() < 3) return 0.0f;
+    std::vector<int> misses = triangleMisses(idx, vertexCount, cacheSize);
+    int total = 0;
+    for (int m : misses) total += m;
+    return (float)total / (float)(idx.size() / 3);
+}
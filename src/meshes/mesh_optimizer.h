@@ -0,0 +1,27 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "mesh_data.h"
+#include <vector>
+
+// Reorders triangles for post-transform vertex cache reuse (Tom Forsyth's
+// "Linear-Speed Vertex Cache Optimisation", LRU cache of 32 entries).
+void optimizeVertexCache(std::vector<unsigned int>& idx, size_t vertexCount);
+
+// Splits the cache-ordered triangle list into clusters at points where the cache
+// is cold anyway, then sorts clusters front-to-back-ish (outward facing first) so
+// early depth testing rejects more fragments. Clusters are only split where the
+// running ACMR stays within `threshold` of the input, so cache efficiency is kept.
+void optimizeOverdraw(std::vector<unsigned int>& idx, const MeshData& data, float threshold = 1.05f);
+
+// Renumbers vertices in first-use order so vertex fetch walks memory linearly.
+// Unreferenced vertices are dropped.
+void optimizeVertexFetch(MeshData& data);
+
+// All three passes in order; used on generated meshes before upload
+void optimizeMesh(MeshData& data);
+
+// Average cache miss ratio (transformed vertices per triangle) for a FIFO cache
+float computeACMR(const std::vector<unsigned int>& idx, size_t vertexCount, int cacheSize = 16);
+
+#endif // MESH_OPTIMIZER_H
@@ -0,0 +1,84 @@
+#include "road_mesher.h"
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <set>
+
+std::vector<RoadRun> groupRoadRuns(const std::vector<std::pair<int,int>>& cells) {
+    std::set<std::pair<int,int>> cellSet(cells.begin(), cells.end());
+    auto has = [&](int x, int z) { return cellSet.count({x, z}) > 0; };
+    std::vector<RoadRun> runs;
+
+    // Horizontal pass: cells with a left/right neighbour (intersections included).
+    // std::set orders by (x,z), so walk each row starting from its leftmost cell.
+    std::set<std::pair<int,int>> claimed;
+    for (auto& c : cellSet) {
+        int x = c.first, z = c.second;
+        if (has(x - 1, z) || !has(x + 1, z)) continue; // not the start of a horizontal run
+        int len = 1;
+        while (has(x + len, z)) len++;
+        runs.push_back({x, z, len, false});
+        for (int k = 0; k < len; k++) claimed.insert({x + k, z});
+    }
+
+    // Vertical pass over whatever is left (single cells become 1-long vertical runs)
+    for (auto& c : cellSet) {
+        if (claimed.count(c)) continue;
+        int x = c.first, z = c.second;
+        if (has(x, z - 1) && !claimed.count({x, z - 1})) continue;
+        int len = 1;
+        while (has(x, z + len) && !claimed.count({x, z + len})) len++;
+        runs.push_back({x, z, len, true});
+        for (int k = 0; k < len; k++) claimed.insert({x, z + k});
+    }
+    return runs;
+}
+
+MeshData makeRoadStripData(const std::vector<RoadRun>& runs, float originX, float originZ, float y) {
+    MeshData data;
+    std::vector<float>& verts = data.verts;
+    std::vector<unsigned int>& idx = data.idx;
+    verts.reserve(runs.size() * 4 * 8);
+    idx.reserve(runs.size() * 6);
+
+    for (auto& r : runs) {
+        float x0 = originX + (float)r.x - 0.5f;
+        float z0 = originZ + (float)r.z - 0.5f;
+        float x1 = x0 + (r.vertical ? 1.0f : (float)r.length);
+        float z1 = z0 + (r.vertical ? (float)r.length : 1.0f);
+
+        // u follows the road in absolute cell units, so split runs line up;
+        // vertical runs match the old 90 degree rotated quad (u grows towards -z)
+        float u[4], v[4];
+        if (!r.vertical) {
+            float ua = (float)r.x, ub = (float)(r.x + r.length);
+            u[0] = ua; v[0] = 1.0f;   // (x0, z1)
+            u[1] = ub; v[1] = 1.0f;   // (x1, z1)
+            u[2] = ub; v[2] = 0.0f;   // (x1, z0)
+            u[3] = ua; v[3] = 0.0f;   // (x0, z0)
+        } else {
+            float ua = -(float)(r.z + r.length), ub = -(float)r.z;
+            u[0] = ua; v[0] = 0.0f;
+            u[1] = ua; v[1] = 1.0f;
+            u[2] = ub; v[2] = 1.0f;
+            u[3] = ub; v[3] = 0.0f;
+        }
+        float px[4] = { x0, x1, x1, x0 };
+        float pz[4] = { z1, z1, z0, z0 };
+
+        unsigned int base = (unsigned int)(verts.size() / 8);
+        for (int k = 0; k < 4; k++) {
+            verts.push_back(px[k]); verts.push_back(y); verts.push_back(pz[k]);
+            verts.push_back(0); verts.push_back(1); verts.push_back(0);
+            verts.push_back(u[k]); verts.push_back(v[k]);
+        }
+        unsigned int q[6] = { 0,1,2, 0,2,3 };
+        for (unsigned int k : q) idx.push_back(base + k);
+    }
+    return data;
+}
+
+Mesh makeRoadStrips(const std::vector<RoadRun>& runs, float originX, float originZ, float y) {
+    MeshData data = makeRoadStripData(runs, originX, originZ, y);
+    optimizeMesh(data);
+    return buildMesh(data);
+}
@@ -0,0 +1,24 @@
+#ifndef ROAD_MESHER_H
+#define ROAD_MESHER_H
+
+#include "mesh.h"
+#include <vector>
+#include <utility>
+
+// A straight run of contiguous road cells along one grid axis
+struct RoadRun {
+    int x, z;        // first cell of the run (lowest coordinate along the run)
+    int length;      // number of cells
+    bool vertical;   // true = runs along z, false = runs along x
+};
+
+// Groups rasterized road cells (e.g. from bresenhamLine) into axis-aligned runs.
+// Duplicate cells are ignored; every cell ends up in exactly one run.
+std::vector<RoadRun> groupRoadRuns(const std::vector<std::pair<int,int>>& cells);
+
+// Builds one mesh holding a textured strip per run. Cells are unit squares centered
+// on (originX + x, originZ + z); u runs along the road so the texture stays continuous.
+MeshData makeRoadStripData(const std::vector<RoadRun>& runs, float originX, float originZ, float y = 0.02f);
+Mesh makeRoadStrips(const std::vector<RoadRun>& runs, float originX, float originZ, float y = 0.02f);
+
+#endif // ROAD_MESHER_H
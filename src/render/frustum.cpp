@@ -0,0 +1,115 @@
+#include "frustum.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+    // rows of the (column-major) matrix
+    glm::vec4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    Frustum f;
+    f.planes[0] = r3 + r0; // left
+    f.planes[1] = r3 - r0; // right
+    f.planes[2] = r3 + r1; // bottom
+    f.planes[3] = r3 - r1; // top
+    f.planes[4] = r3 + r2; // near
+    f.planes[5] = r3 - r2; // far
+    for (auto& p : f.planes) {
+        float len = glm::length(glm::vec3(p));
+        if (len > 0.0f) p = p / len;
+    }
+    return f;
+}
+
+bool Frustum::intersects(const AABB& box) const {
+    glm::vec3 c = (box.min + box.max) * 0.5f;
+    glm::vec3 e = (box.max - box.min) * 0.5f;
+    for (const auto& p : planes) {
+        glm::vec3 n(p);
+        if (glm::dot(n, c) + glm::dot(glm::abs(n), e) + p.w < 0.0f) return false;
+    }
+    return true;
+}
+
+Frustum::Result Frustum::classify(const AABB& box) const {
+    glm::vec3 c = (box.min + box.max) * 0.5f;
+    glm::vec3 e = (box.max - box.min) * 0.5f;
+    Result r = Inside;
+    for (const auto& p : planes) {
+        glm::vec3 n(p);
+        float d = glm::dot(n, c) + p.w;
+        float radius = glm::dot(glm::abs(n), e);
+        if (d + radius < 0.0f) return Outside;
+        if (d - radius < 0.0f) r = Intersects;
+    }
+    return r;
+}
+
+size_t AABBList::add(const AABB& box) {
+    size_t i = count++;
+    if (cx.size() < count) {
+        size_t padded = (count + 3) & ~(size_t)3;
+        for (auto* v : { &cx, &cy, &cz, &ex, &ey, &ez }) v->resize(padded, 0.0f);
+    }
+    set(i, box);
+    return i;
+}
+
+void AABBList::set(size_t i, const AABB& box) {
+    glm::vec3 c = (box.min + box.max) * 0.5f;
+    glm::vec3 e = (box.max - box.min) * 0.5f;
+    cx[i] = c.x; cy[i] = c.y; cz[i] = c.z;
+    ex[i] = e.x; ey[i] = e.y; ez[i] = e.z;
+}
+
+AABB AABBList::get(size_t i) const {
+    AABB b;
+    b.min = glm::vec3(cx[i] - ex[i], cy[i] - ey[i], cz[i] - ez[i]);
+    b.max = glm::vec3(cx[i] + ex[i], cy[i] + ey[i], cz[i] + ez[i]);
+    return b;
+}
+
+void AABBList::clear() {
+    for (auto* v : { &cx, &cy, &cz, &ex, &ey, &ez }) v->clear();
+    count = 0;
+}
+
+void cullAABBs(const Frustum& f, const AABBList& boxes, std::vector<uint8_t>& visible) {
+    size_t n = boxes.size();
+    visible.resize(n);
+    size_t i = 0;
+#ifdef FRUSTUM_SSE
+    // box is outside if for some plane: dot(n, c) + dot(|n|, e) + d < 0
+    __m128 pn[6][3], pa[6][3], pd[6];
+    for (int p = 0; p < 6; p++) {
+        for (int k = 0; k < 3; k++) {
+            pn[p][k] = _mm_set1_ps(f.planes[p][k]);
+            pa[p][k] = _mm_set1_ps(std::fabs(f.planes[p][k]));
+        }
+        pd[p] = _mm_set1_ps(f.planes[p].w);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 cx = _mm_loadu_ps(&boxes.cx[i]), cy = _mm_loadu_ps(&boxes.cy[i]), cz = _mm_loadu_ps(&boxes.cz[i]);
+        __m128 ex = _mm_loadu_ps(&boxes.ex[i]), ey = _mm_loadu_ps(&boxes.ey[i]), ez = _mm_loadu_ps(&boxes.ez[i]);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pn[p][0], cx), _mm_mul_ps(pn[p][1], cy)),
+                                  _mm_add_ps(_mm_mul_ps(pn[p][2], cz), pd[p]));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pa[p][0], ex), _mm_mul_ps(pa[p][1], ey)), _mm_mul_ps(pa[p][2], ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+        }
+        int mask = _mm_movemask_ps(inside);
+        visible[i]   = (mask >> 0) & 1;
+        visible[i+1] = (mask >> 1) & 1;
+        visible[i+2] = (mask >> 2) & 1;
+        visible[i+3] = (mask >> 3) & 1;
+    }
+#endif
+    for (; i < n; i++) visible[i] = f.intersects(boxes.get(i)) ? 1 : 0;
+}
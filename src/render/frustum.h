@@ -0,0 +1,42 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// World-space axis-aligned bounding box
+struct AABB {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+// Six inward-facing planes (xyz = normal, w = distance), extracted from a
+// view-projection matrix (Gribb/Hartmann)
+struct Frustum {
+    enum Result { Outside = 0, Intersects = 1, Inside = 2 };
+    glm::vec4 planes[6];
+    static Frustum fromMatrix(const glm::mat4& viewProj);
+    bool intersects(const AABB& box) const;
+    Result classify(const AABB& box) const;
+};
+
+// Boxes stored as centers/extents in separate arrays, padded to a multiple of 4
+// so the SIMD test can load 4 boxes per iteration
+class AABBList {
+public:
+    size_t add(const AABB& box); // returns the box index
+    void set(size_t i, const AABB& box);
+    AABB get(size_t i) const;
+    void clear();
+    size_t size() const { return count; }
+
+    std::vector<float> cx, cy, cz, ex, ey, ez;
+private:
+    size_t count = 0;
+};
+
+// visible[i] = 1 if box i is at least partly inside the frustum (SSE, 4 boxes at a time)
+void cullAABBs(const Frustum& frustum, const AABBList& boxes, std::vector<uint8_t>& visible);
+
+#endif // FRUSTUM_H
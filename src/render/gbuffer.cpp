@@ -0,0 +1,89 @@
+#include "gbuffer.h"
+#include <iostream>
+
+GBuffer::~GBuffer() {
+    destroy();
+    if (emptyVao) glDeleteVertexArrays(1, &emptyVao);
+}
+
+void GBuffer::destroy() {
+    GLuint texs[4] = { albedoTex, normalTex, emissiveTex, depthTex };
+    if (albedoTex) glDeleteTextures(4, texs);
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+    fbo = albedoTex = normalTex = emissiveTex = depthTex = 0;
+}
+
+static GLuint createTarget(GLenum internalFormat, GLenum format, GLenum type, int w, int h) {
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format, type, NULL);
+    // read back with texelFetch, one texel per pixel
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return tex;
+}
+
+bool GBuffer::resize(int w, int h) {
+    if (w == width && h == height) return fbo != 0 && !failed;
+    destroy();
+    width = w;
+    height = h;
+    failed = false;
+    if (w <= 0 || h <= 0) return false;
+
+    albedoTex = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, w, h);
+    normalTex = createTarget(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, w, h);
+    emissiveTex = createTarget(GL_R11F_G11F_B10F, GL_RGB, GL_HALF_FLOAT, w, h);
+    depthTex = createTarget(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, w, h);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, emissiveTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
+    GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, drawBuffers);
+    bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!ok) {
+        std::cerr << "G-buffer framebuffer incomplete (" << w << "x" << h << ")\n";
+        destroy();
+        failed = true;
+        return false;
+    }
+    if (!emptyVao) glGenVertexArrays(1, &emptyVao);
+    std::cout << "G-buffer allocated: " << w << "x" << h << "\n";
+    return true;
+}
+
+void GBuffer::beginGeometry() {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // albedo a = 0: unlit, so empty pixels stay black
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GBuffer::end() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GBuffer::bindTextures(const Shader& shader, int firstUnit) const {
+    GLuint texs[4] = { albedoTex, normalTex, emissiveTex, depthTex };
+    const char* names[4] = { "gAlbedo", "gNormal", "gEmissive", "gDepth" };
+    for (int i = 0; i < 4; i++) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_2D, texs[i]);
+        shader.setInt(names[i], firstUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void GBuffer::drawFullscreen() const {
+    glBindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+}
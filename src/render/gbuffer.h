@@ -0,0 +1,39 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <GL/glew.h>
+#include "shader.h"
+
+// Render targets of the deferred path. The geometry pass (SHADER_GBUFFER variants)
+// writes surface attributes; the light pass (SHADER_LIGHT_PASS) reads them back per
+// pixel and reconstructs the position from depth.
+//   0: albedo        RGBA8          rgb color, a = 0 unlit / 0.5 lit / 1 lit, ambient and static lamps baked
+//   1: normal        RGBA16F        octahedral normal (rg), specular strength, exponent / 128
+//   2: emissive      R11F_G11F_B10F added unlit; lightmapped surfaces add their baked light here
+//   depth            DEPTH24 texture
+class GBuffer {
+public:
+    GBuffer() {}
+    ~GBuffer();
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    // (Re)allocates the targets when the size changes; false if the FBO is incomplete
+    bool resize(int width, int height);
+    // Binds and clears the targets for the geometry pass
+    void beginGeometry();
+    // Back to the default framebuffer
+    void end();
+    // Binds the targets to units firstUnit..firstUnit+3 and sets the light pass samplers
+    void bindTextures(const Shader& shader, int firstUnit) const;
+    // Attribute-less fullscreen triangle (the light pass builds it from gl_VertexID)
+    void drawFullscreen() const;
+private:
+    GLuint fbo = 0, albedoTex = 0, normalTex = 0, emissiveTex = 0, depthTex = 0;
+    GLuint emptyVao = 0;
+    int width = 0, height = 0;
+    bool failed = false; // incomplete at this size; don't retry every frame
+    void destroy();
+};
+
+#endif // GBUFFER_H
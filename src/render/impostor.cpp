@@ -0,0 +1,188 @@
+#include "impostor.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const char* impostorVertexSrc = R"glsl(
+#version 330 core
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aUV;
+layout(location=2) in float aFade;
+uniform mat4 view;
+uniform mat4 proj;
+out vec2 vUV;
+out float vFade;
+void main(){
+    vUV = aUV;
+    vFade = aFade;
+    gl_Position = proj * view * vec4(aPos, 1.0);
+}
+)glsl";
+
+static const char* impostorFragmentSrc = R"glsl(
+#version 330 core
+in vec2 vUV;
+in float vFade;
+out vec4 FragColor;
+uniform sampler2D atlas;
+// same pattern as screenDoor() in assets/shaders/scene.frag
+float screenDoor(vec2 fragCoord) {
+    ivec2 p = ivec2(fragCoord) & 3;
+    int v = p.x ^ p.y;
+    return float(((v & 1) << 3) | ((p.y & 1) << 2) | (v & 2) | ((p.y >> 1) & 1)) * (1.0 / 16.0) + (0.5 / 16.0);
+}
+void main(){
+    vec4 c = texture(atlas, vUV);
+    if (c.a < 0.5) discard; // cut out the empty part of the cell
+    // while fading in, keep only the pixels the dissolving building drops
+    if (screenDoor(gl_FragCoord.xy) >= vFade) discard;
+    FragColor = vec4(c.rgb, 1.0);
+}
+)glsl";
+
+ImpostorAtlas::~ImpostorAtlas() {
+    if (depthRb) glDeleteRenderbuffers(1, &depthRb);
+    if (colorTex) glDeleteTextures(1, &colorTex);
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+}
+
+bool ImpostorAtlas::create(int classCount, int cell) {
+    classes = classCount;
+    cellSize = cell;
+    int w = cellSize * kViews, h = cellSize * std::max(classCount, 1);
+
+    glGenTextures(1, &colorTex);
+    glBindTexture(GL_TEXTURE_2D, colorTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // limit mips so neighbouring cells do not bleed into each other
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 4);
+
+    glGenRenderbuffers(1, &depthRb);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRb);
+    bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
+    glViewport(0, 0, w, h);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // alpha 0 marks empty texels
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (!ok) {
+        std::cerr << "Impostor atlas framebuffer incomplete\n";
+        finish();
+        glDeleteRenderbuffers(1, &depthRb); depthRb = 0;
+        glDeleteTextures(1, &colorTex); colorTex = 0;
+        glDeleteFramebuffers(1, &fbo); fbo = 0;
+    }
+    return ok;
+}
+
+void ImpostorAtlas::renderClass(int classIndex, const Shader& shader, const glm::vec3& center, float halfExtent,
+                                const std::function<void()>& drawGeometry) {
+    if (!fbo) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glm::mat4 proj = glm::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, 0.1f, halfExtent * 4.0f);
+    shader.use();
+    shader.setMat4("proj", proj);
+    for (int v = 0; v < kViews; v++) {
+        float a = (float)v * 2.0f * 3.14159265f / kViews;
+        glm::vec3 eye = center + glm::vec3(cosf(a), 0.0f, sinf(a)) * (halfExtent * 2.0f);
+        glViewport(v * cellSize, classIndex * cellSize, cellSize, cellSize);
+        shader.setMat4("view", glm::lookAt(eye, center, glm::vec3(0, 1, 0)));
+        shader.setVec3("viewPos", eye);
+        drawGeometry();
+    }
+}
+
+void ImpostorAtlas::finish() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+    if (colorTex) {
+        glBindTexture(GL_TEXTURE_2D, colorTex);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+int ImpostorAtlas::viewIndex(const glm::vec3& toCamera) {
+    float a = atan2f(toCamera.z, toCamera.x);
+    if (a < 0.0f) a += 2.0f * 3.14159265f;
+    int v = (int)floorf(a / (2.0f * 3.14159265f / kViews) + 0.5f);
+    return v % kViews;
+}
+
+glm::vec4 ImpostorAtlas::cellRect(int classIndex, int view) const {
+    float du = 1.0f / kViews, dv = 1.0f / std::max(classes, 1);
+    // half-texel inset keeps bilinear filtering inside the cell
+    float iu = 0.5f / (float)(cellSize * kViews), iv = 0.5f / (float)(cellSize * std::max(classes, 1));
+    return glm::vec4(view * du + iu, classIndex * dv + iv, (view + 1) * du - iu, (classIndex + 1) * dv - iv);
+}
+
+ImpostorBatch::~ImpostorBatch() {
+    if (vbo) glDeleteBuffers(1, &vbo);
+    if (vao) glDeleteVertexArrays(1, &vao);
+}
+
+void ImpostorBatch::init() {
+    shader.reset(new Shader(impostorVertexSrc, impostorFragmentSrc));
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)(3*sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)(5*sizeof(float)));
+    glBindVertexArray(0);
+}
+
+void ImpostorBatch::begin() {
+    verts.clear();
+}
+
+void ImpostorBatch::add(const glm::vec3& center, float halfExtent, float depthOffset, const glm::vec3& eye,
+                        const glm::vec4& uvRect, float fade) {
+    glm::vec3 toCam = eye - center;
+    toCam.y = 0.0f;
+    float len = glm::length(toCam);
+    glm::vec3 dir = len > 1e-4f ? toCam / len : glm::vec3(1, 0, 0);
+    // same basis as the atlas camera: right = cross(forward, up) with forward = -dir
+    glm::vec3 right = glm::cross(-dir, glm::vec3(0, 1, 0)) * halfExtent;
+    glm::vec3 up = glm::vec3(0.0f, halfExtent, 0.0f);
+    glm::vec3 c = center + dir * depthOffset;
+
+    glm::vec3 p[4] = { c - right - up, c + right - up, c + right + up, c - right + up };
+    float uv[4][2] = { {uvRect.x, uvRect.y}, {uvRect.z, uvRect.y}, {uvRect.z, uvRect.w}, {uvRect.x, uvRect.w} };
+    int order[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int k : order) {
+        float v[6] = { p[k].x, p[k].y, p[k].z, uv[k][0], uv[k][1], fade };
+        verts.insert(verts.end(), v, v + 6);
+    }
+}
+
+void ImpostorBatch::draw(const glm::mat4& view, const glm::mat4& proj, GLuint atlasTex) {
+    if (verts.empty() || !atlasTex) return;
+    if (!shader) init();
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, verts.size()*sizeof(float), verts.data(), GL_STREAM_DRAW);
+
+    shader->use();
+    shader->setMat4("view", view);
+    shader->setMat4("proj", proj);
+    shader->setInt("atlas", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlasTex);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(verts.size() / 6));
+    glBindVertexArray(0);
+}
@@ -0,0 +1,72 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "shader.h"
+
+// Offscreen atlas of pre-rendered building views: one row per impostor class
+// (building type / height class), kViews columns of views around the Y axis.
+class ImpostorAtlas {
+public:
+    static const int kViews = 8;
+
+    ImpostorAtlas() {}
+    ~ImpostorAtlas();
+    ImpostorAtlas(const ImpostorAtlas&) = delete;
+    ImpostorAtlas& operator=(const ImpostorAtlas&) = delete;
+
+    // Allocates the atlas texture + FBO; returns false if the FBO is incomplete
+    bool create(int classCount, int cellSize = 128);
+
+    // Renders one class from every view into its row. `shader` must already have the
+    // lighting uniforms set; view/proj/viewPos are set here, then drawGeometry() issues
+    // the draw calls. center/halfExtent describe the square the billboard will cover.
+    void renderClass(int classIndex, const Shader& shader, const glm::vec3& center, float halfExtent,
+                     const std::function<void()>& drawGeometry);
+
+    // Restores the default framebuffer/viewport and builds mipmaps
+    void finish();
+
+    // Nearest pre-rendered view for a camera at azimuth `toCamera` (xz) from the object
+    static int viewIndex(const glm::vec3& toCamera);
+    // Atlas uv rect (x0, y0, x1, y1) of a class/view cell
+    glm::vec4 cellRect(int classIndex, int view) const;
+
+    GLuint texture() const { return colorTex; }
+    bool ready() const { return colorTex != 0; }
+private:
+    GLuint fbo = 0, colorTex = 0, depthRb = 0;
+    int cellSize = 0, classes = 0;
+    GLint savedViewport[4] = {0, 0, 0, 0};
+};
+
+// Per-frame batch of camera-facing (Y-axis) quads sampling the atlas; one draw call.
+// Quads are opaque cutouts (depth tested and written like the geometry), so they need
+// no sorting; a fading quad covers only its share of an ordered dither pattern.
+class ImpostorBatch {
+public:
+    ImpostorBatch() {}
+    ~ImpostorBatch();
+    ImpostorBatch(const ImpostorBatch&) = delete;
+    ImpostorBatch& operator=(const ImpostorBatch&) = delete;
+
+    void begin();
+    // center/halfExtent as passed to renderClass; `depthOffset` pulls the quad towards the
+    // camera so it is not hidden by the building's own front faces. fade (0..1] is the
+    // share of dither cells drawn: the complement of the building's `dissolve` uniform
+    void add(const glm::vec3& center, float halfExtent, float depthOffset, const glm::vec3& eye,
+             const glm::vec4& uvRect, float fade);
+    void draw(const glm::mat4& view, const glm::mat4& proj, GLuint atlasTex);
+    size_t count() const { return verts.size() / (6 * 6); }
+private:
+    std::unique_ptr<Shader> shader; // created on first draw
+    GLuint vao = 0, vbo = 0;
+    std::vector<float> verts; // pos(3) uv(2) fade(1), 6 vertices per quad
+    void init();
+};
+
+#endif // IMPOSTOR_H
@@ -0,0 +1,63 @@
+#include "instance_buffer.h"
+
+InstanceBuffer::~InstanceBuffer() {
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (buffer) glDeleteBuffers(1, &buffer);
+}
+
+void InstanceBuffer::create(const Mesh& mesh) {
+    elemCount = mesh.elemCount;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &buffer);
+    glBindVertexArray(vao);
+    // same interleaved layout as buildMesh: pos(3) normal(3) uv(2)
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+    // one mat4 per instance, as four vec4 columns
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (int c = 0; c < 4; c++) {
+        glEnableVertexAttribArray(3 + c);
+        glVertexAttribDivisor(3 + c, 1);
+    }
+    pointAt(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::upload(const glm::mat4* data, size_t count, size_t begin, size_t end) {
+    if (!buffer) return;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (count != allocated) {
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), data, GL_DYNAMIC_DRAW);
+        allocated = count;
+    } else if (begin < end) {
+        glBufferSubData(GL_ARRAY_BUFFER, begin * sizeof(glm::mat4), (end - begin) * sizeof(glm::mat4), data + begin);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::pointAt(size_t first) const {
+    // expects the VAO and the instance buffer to be bound
+    for (int c = 0; c < 4; c++)
+        glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(first * sizeof(glm::mat4) + c * sizeof(glm::vec4)));
+    boundFirst = first;
+}
+
+void InstanceBuffer::draw(size_t first, size_t count) const {
+    if (!vao || count == 0 || first + count > allocated) return;
+    glBindVertexArray(vao);
+    if (first != boundFirst) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        pointAt(first);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glDrawElementsInstanced(GL_TRIANGLES, elemCount, GL_UNSIGNED_INT, 0, (GLsizei)count);
+    glBindVertexArray(0);
+}
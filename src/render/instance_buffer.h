@@ -0,0 +1,36 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include "../meshes/mesh.h"
+
+// Per-instance model matrices for one mesh, read by the SHADER_INSTANCED variants as
+// attributes 3..6. Owns a VAO over the mesh's vertex and index buffers, so the mesh's
+// own VAO is left untouched for regular draws.
+class InstanceBuffer {
+public:
+    InstanceBuffer() {}
+    ~InstanceBuffer();
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // Needs a GL context; the mesh must outlive the buffer
+    void create(const Mesh& mesh);
+    // Uploads matrices [begin, end) of the `count` in data; everything is uploaded when
+    // count differs from the last call (the buffer is reallocated)
+    void upload(const glm::mat4* data, size_t count, size_t begin, size_t end);
+    // Draws instances [first, first + count). GL 3.3 has no base instance, so the
+    // attribute pointers are moved to `first` instead
+    void draw(size_t first, size_t count) const;
+    size_t size() const { return allocated; }
+private:
+    GLuint vao = 0, buffer = 0;
+    GLsizei elemCount = 0;
+    size_t allocated = 0;          // matrices in the buffer
+    mutable size_t boundFirst = 0; // instance the attribute pointers start at
+    void pointAt(size_t first) const;
+};
+
+#endif // INSTANCE_BUFFER_H
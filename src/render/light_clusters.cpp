@@ -0,0 +1,199 @@
+#include "light_clusters.h"
+#include "../core/worker_pool.h"
+#include <algorithm>
+#include <cmath>
+
+LightClusters::~LightClusters() {
+    GLuint bufs[3] = { lightBuf, cellBuf, indexBuf };
+    GLuint texs[3] = { lightTex, cellTex, indexTex };
+    if (lightBuf) glDeleteBuffers(3, bufs);
+    if (lightTex) glDeleteTextures(3, texs);
+}
+
+// depth (positive distance) of the near plane of slice k
+static float sliceDepth(int k, float zNear, float zFar) {
+    return zNear * powf(zFar / zNear, (float)k / LightClusters::kSlicesZ);
+}
+
+void LightClusters::buildClusterBounds(const glm::mat4& proj) {
+    clusterMin.resize(kClusterCount);
+    clusterMax.resize(kClusterCount);
+    float sx = 1.0f / proj[0][0], sy = 1.0f / proj[1][1]; // view x/y per unit depth at ndc 1
+    for (int z = 0; z < kSlicesZ; z++) {
+        float d0 = sliceDepth(z, zNear, zFar), d1 = sliceDepth(z + 1, zNear, zFar);
+        for (int y = 0; y < kTilesY; y++) {
+            float ny0 = -1.0f + 2.0f * y / kTilesY, ny1 = -1.0f + 2.0f * (y + 1) / kTilesY;
+            for (int x = 0; x < kTilesX; x++) {
+                float nx0 = -1.0f + 2.0f * x / kTilesX, nx1 = -1.0f + 2.0f * (x + 1) / kTilesX;
+                // tile edges are lines through the eye, so the extremes lie on the slice planes
+                glm::vec3 lo(1e30f), hi(-1e30f);
+                for (float d : { d0, d1 }) {
+                    for (float nx : { nx0, nx1 }) {
+                        for (float ny : { ny0, ny1 }) {
+                            glm::vec3 p(nx * sx * d, ny * sy * d, -d);
+                            lo = glm::min(lo, p);
+                            hi = glm::max(hi, p);
+                        }
+                    }
+                }
+                int c = (z * kTilesY + y) * kTilesX + x;
+                clusterMin[c] = lo;
+                clusterMax[c] = hi;
+            }
+        }
+    }
+    cachedProj = proj;
+}
+
+void LightClusters::build(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& proj,
+                          float nearPlane, float farPlane) {
+    if (proj != cachedProj || nearPlane != zNear || farPlane != zFar) {
+        zNear = nearPlane;
+        zFar = farPlane;
+        buildClusterBounds(proj);
+    }
+    size_t n = lights.size();
+    lightData.resize(n * 8);
+    ranges.resize(n * 6);
+    viewCenters.resize(n);
+    float sx = proj[0][0], sy = proj[1][1];
+    float logRatio = logf(zFar / zNear);
+    WorkerPool& pool = WorkerPool::shared();
+
+    // 1. per light: pack it for the shader and find the cluster range its sphere spans
+    pool.parallelFor(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const PointLight& l = lights[i];
+            float* out = &lightData[i * 8];
+            out[0] = l.position.x; out[1] = l.position.y; out[2] = l.position.z; out[3] = l.radius;
+            out[4] = l.color.x * l.intensity; out[5] = l.color.y * l.intensity; out[6] = l.color.z * l.intensity; out[7] = l.baked ? 1.0f : 0.0f;
+
+            glm::vec3 c = glm::vec3(view * glm::vec4(l.position, 1.0f));
+            viewCenters[i] = c;
+            int* r = &ranges[i * 6];
+            float dNear = std::max(zNear, -c.z - l.radius), dFar = std::min(zFar, -c.z + l.radius);
+            if (dNear > dFar) { r[4] = 1; r[5] = 0; continue; } // outside the depth range
+            // x/y extremes of the sphere's box occur at its nearest or farthest depth
+            float nx0 = 1e30f, nx1 = -1e30f, ny0 = 1e30f, ny1 = -1e30f;
+            for (float d : { dNear, dFar }) {
+                for (float ox : { -l.radius, l.radius }) {
+                    float nx = (c.x + ox) * sx / d;
+                    nx0 = std::min(nx0, nx); nx1 = std::max(nx1, nx);
+                }
+                for (float oy : { -l.radius, l.radius }) {
+                    float ny = (c.y + oy) * sy / d;
+                    ny0 = std::min(ny0, ny); ny1 = std::max(ny1, ny);
+                }
+            }
+            if (nx0 > 1.0f || nx1 < -1.0f || ny0 > 1.0f || ny1 < -1.0f) { r[4] = 1; r[5] = 0; continue; }
+            r[0] = std::max(0, std::min(kTilesX - 1, (int)floorf((nx0 + 1.0f) * 0.5f * kTilesX)));
+            r[1] = std::max(0, std::min(kTilesX - 1, (int)floorf((nx1 + 1.0f) * 0.5f * kTilesX)));
+            r[2] = std::max(0, std::min(kTilesY - 1, (int)floorf((ny0 + 1.0f) * 0.5f * kTilesY)));
+            r[3] = std::max(0, std::min(kTilesY - 1, (int)floorf((ny1 + 1.0f) * 0.5f * kTilesY)));
+            r[4] = std::max(0, std::min(kSlicesZ - 1, (int)floorf(logf(dNear / zNear) / logRatio * kSlicesZ)));
+            r[5] = std::max(0, std::min(kSlicesZ - 1, (int)floorf(logf(dFar / zNear) / logRatio * kSlicesZ)));
+        }
+    }, 64);
+
+    // 2. bucket lights by depth slice (cheap, serial)
+    sliceLights.resize(kSlicesZ);
+    sliceIndices.resize(kSlicesZ);
+    sliceCounts.resize(kSlicesZ);
+    for (auto& s : sliceLights) s.clear();
+    for (size_t i = 0; i < n; i++)
+        for (int z = ranges[i * 6 + 4]; z <= ranges[i * 6 + 5]; z++) sliceLights[z].push_back((uint32_t)i);
+
+    // 3. per slice: exact sphere vs cluster box tests, giving per-cluster index lists
+    pool.parallelFor(kSlicesZ, [&](size_t begin, size_t end) {
+        std::vector<std::vector<uint32_t>> local(kTilesX * kTilesY);
+        for (size_t z = begin; z < end; z++) {
+            for (auto& l : local) l.clear();
+            for (uint32_t i : sliceLights[z]) {
+                const int* r = &ranges[i * 6];
+                glm::vec3 c = viewCenters[i];
+                float r2 = lights[i].radius * lights[i].radius;
+                for (int y = r[2]; y <= r[3]; y++) {
+                    for (int x = r[0]; x <= r[1]; x++) {
+                        int cl = ((int)z * kTilesY + y) * kTilesX + x;
+                        glm::vec3 q = glm::clamp(c, clusterMin[cl], clusterMax[cl]);
+                        glm::vec3 dv = q - c;
+                        if (glm::dot(dv, dv) <= r2) local[y * kTilesX + x].push_back(i);
+                    }
+                }
+            }
+            std::vector<uint32_t>& idx = sliceIndices[z];
+            std::vector<uint32_t>& cnt = sliceCounts[z];
+            idx.clear();
+            cnt.assign(kTilesX * kTilesY, 0);
+            for (int t = 0; t < kTilesX * kTilesY; t++) {
+                cnt[t] = (uint32_t)local[t].size();
+                idx.insert(idx.end(), local[t].begin(), local[t].end());
+            }
+        }
+    });
+
+    // 4. concatenate slices into one index list with (offset, count) per cluster
+    cells.resize(kClusterCount * 2);
+    indices.clear();
+    for (int z = 0; z < kSlicesZ; z++) {
+        uint32_t offset = (uint32_t)indices.size();
+        for (int t = 0; t < kTilesX * kTilesY; t++) {
+            int cl = z * kTilesX * kTilesY + t;
+            cells[cl * 2] = offset;
+            cells[cl * 2 + 1] = sliceCounts[z][t];
+            offset += sliceCounts[z][t];
+        }
+        indices.insert(indices.end(), sliceIndices[z].begin(), sliceIndices[z].end());
+    }
+}
+
+void LightClusters::createBuffers() {
+    GLuint bufs[3], texs[3];
+    glGenBuffers(3, bufs);
+    glGenTextures(3, texs);
+    lightBuf = bufs[0]; cellBuf = bufs[1]; indexBuf = bufs[2];
+    lightTex = texs[0]; cellTex = texs[1]; indexTex = texs[2];
+    GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+    for (int i = 0; i < 3; i++) {
+        glBindBuffer(GL_TEXTURE_BUFFER, bufs[i]);
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, texs[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], bufs[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::upload() {
+    if (!lightBuf) createBuffers();
+    // orphan + refill each frame so the driver never waits on last frame's reads
+    auto fill = [](GLuint buf, const void* data, size_t bytes) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buf);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(bytes, 16), NULL, GL_STREAM_DRAW);
+        if (bytes) glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+    };
+    fill(lightBuf, lightData.data(), lightData.size() * sizeof(float));
+    fill(cellBuf, cells.data(), cells.size() * sizeof(uint32_t));
+    fill(indexBuf, indices.data(), indices.size() * sizeof(uint32_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::bind(const Shader& shader, int firstUnit, bool enabled) const {
+    GLuint texs[3] = { lightTex, cellTex, indexTex };
+    const char* names[3] = { "lightData", "clusterCells", "lightIndices" };
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_BUFFER, texs[i]);
+        shader.setInt(names[i], firstUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("clusterSlices", (enabled && lightTex) ? kSlicesZ : 0);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    shader.setIVec2("clusterTiles", kTilesX, kTilesY);
+    shader.setVec2("clusterTileSize", glm::vec2((float)viewport[2] / kTilesX, (float)viewport[3] / kTilesY));
+    // slice = log(depth) * zScale + zBias
+    float logRatio = logf(zFar / zNear);
+    shader.setFloat("clusterZScale", kSlicesZ / logRatio);
+    shader.setFloat("clusterZBias", -kSlicesZ * logf(zNear) / logRatio);
+}
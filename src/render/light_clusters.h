@@ -0,0 +1,68 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "shader.h"
+
+// World-space point light with a finite range (no contribution beyond `radius`)
+struct PointLight {
+    glm::vec3 position = glm::vec3(0.0f);
+    float radius = 1.0f;
+    glm::vec3 color = glm::vec3(1.0f);
+    float intensity = 1.0f;
+    bool baked = false; // static, already in the lightmap; lightmapped surfaces skip it
+};
+
+// Clustered forward lighting: the view frustum is split into kTilesX x kTilesY screen
+// tiles and kSlicesZ exponential depth slices; every frame each cluster gets the list
+// of lights whose sphere touches it. Lights, per-cluster (offset, count) pairs and the
+// index lists go to the shader as texture buffers (GL 3.3 has no SSBOs).
+class LightClusters {
+public:
+    static const int kTilesX = 16, kTilesY = 9, kSlicesZ = 24;
+    static const int kClusterCount = kTilesX * kTilesY * kSlicesZ;
+
+    LightClusters() {}
+    ~LightClusters();
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // CPU binning (parallel over depth slices); proj must be a symmetric perspective
+    void build(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& proj,
+               float zNear, float zFar);
+    // Uploads the last build() into the texture buffers
+    void upload();
+    // Binds the buffers to texture units firstUnit..firstUnit+2 and sets the shader's
+    // cluster uniforms; enabled = false makes the shader skip lamp lighting
+    void bind(const Shader& shader, int firstUnit, bool enabled = true) const;
+
+    size_t lightCount() const { return lightData.size() / 8; }
+    size_t indexCount() const { return indices.size(); }
+    // (offset, count) into the index list, for cluster (x, y, z)
+    const uint32_t* cell(int x, int y, int z) const { return &cells[2 * ((z * kTilesY + y) * kTilesX + x)]; }
+    const std::vector<uint32_t>& lightIndices() const { return indices; }
+private:
+    // view-space bounds of every cluster, rebuilt when the projection changes
+    std::vector<glm::vec3> clusterMin, clusterMax;
+    glm::mat4 cachedProj = glm::mat4(0.0f);
+    float zNear = 0.1f, zFar = 100.0f;
+
+    std::vector<float> lightData;  // 2 x vec4 per light: position + radius, color * intensity + baked flag
+    std::vector<uint32_t> cells;   // offset, count per cluster
+    std::vector<uint32_t> indices;
+    // per-light cluster ranges, and per-slice scratch filled by the parallel pass
+    std::vector<int> ranges;       // x0, x1, y0, y1, z0, z1 per light (z0 > z1 = culled)
+    std::vector<glm::vec3> viewCenters;
+    std::vector<std::vector<uint32_t>> sliceLights, sliceIndices, sliceCounts;
+
+    GLuint lightBuf = 0, cellBuf = 0, indexBuf = 0;
+    GLuint lightTex = 0, cellTex = 0, indexTex = 0;
+
+    void buildClusterBounds(const glm::mat4& proj);
+    void createBuffers();
+};
+
+#endif // LIGHT_CLUSTERS_H
@@ -0,0 +1,328 @@
+#include "lightmap.h"
+#include "../algorithms/bvh.h"
+#include "../core/atomic_file.h"
+#include "../core/worker_pool.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char kMagic[4] = {'C', 'L', 'M', 'P'};
+const uint32_t kVersion = 1; // bump when the bake changes, so old cache entries miss
+
+const float kAmbient = 0.15f;      // matches the shader's unbaked night ambient
+const float kAmbientReach = 15.0f; // occluders further away than this don't darken the sky
+const float kSurfaceOffset = 0.02f;
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    int32_t atlasW, atlasH, groundNx, groundNz;
+    float groundMin[2], groundMax[2];
+    uint32_t chartCount;
+};
+
+uint64_t fnv1a(const void* data, size_t bytes, uint64_t h) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < bytes; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// texels covering `extent` at `density`, with the first and last centered on the edges
+int chartTexels(float extent, int density) {
+    return std::max(2, (int)std::ceil(extent * density) + 1);
+}
+
+// cheap integer hash, for a per-texel rotation of the ambient ray pattern
+float hashAngle(uint32_t x, uint32_t y) {
+    uint32_t h = x * 73856093u ^ y * 19349663u;
+    h ^= h >> 13; h *= 0x5bd1e995u; h ^= h >> 15;
+    return (h & 0xffffu) / 65536.0f * 6.2831853f;
+}
+
+} // namespace
+
+Lightmap::~Lightmap() {
+    if (atlasTex) glDeleteTextures(1, &atlasTex);
+    if (chartTex) glDeleteTextures(1, &chartTex);
+    if (chartBuf) glDeleteBuffers(1, &chartBuf);
+}
+
+uint64_t Lightmap::layoutKey(const LightmapInputs& in) {
+    uint64_t h = fnv1a(&kVersion, sizeof(kVersion), 14695981039346656037ull);
+    for (const AABB& b : in.occluders) {
+        h = fnv1a(&b.min, sizeof(b.min), h);
+        h = fnv1a(&b.max, sizeof(b.max), h);
+    }
+    uint64_t buildings = in.buildingCount;
+    h = fnv1a(&buildings, sizeof(buildings), h);
+    for (size_t i = 0; i < in.lights.size(); i++) {
+        const PointLight& l = in.lights[i];
+        float v[8] = { l.position.x, l.position.y, l.position.z, l.radius, l.color.x, l.color.y, l.color.z, l.intensity };
+        h = fnv1a(v, sizeof(v), h);
+        int owner = i < in.lightOwners.size() ? in.lightOwners[i] : -1;
+        h = fnv1a(&owner, sizeof(owner), h);
+    }
+    h = fnv1a(&in.groundMin, sizeof(in.groundMin), h);
+    return fnv1a(&in.groundMax, sizeof(in.groundMax), h);
+}
+
+void Lightmap::layoutCharts(const LightmapInputs& in) {
+    groundMin = in.groundMin;
+    groundMax = in.groundMax;
+    groundNx = chartTexels(groundMax.x - groundMin.x, kGroundTexelsPerUnit);
+    groundNz = chartTexels(groundMax.y - groundMin.y, kGroundTexelsPerUnit);
+    atlasW = std::max(kAtlasWidth, groundNx);
+
+    buildings.assign(in.occluders.begin(), in.occluders.begin() + std::min(in.buildingCount, in.occluders.size()));
+    charts.assign(buildings.size(), FacadeChart());
+    std::vector<size_t> order(buildings.size());
+    for (size_t i = 0; i < buildings.size(); i++) {
+        const AABB& b = buildings[i];
+        charts[i].nx = chartTexels(b.max.x - b.min.x, kFacadeTexelsPerUnit);
+        charts[i].nz = chartTexels(b.max.z - b.min.z, kFacadeTexelsPerUnit);
+        charts[i].rows = chartTexels(b.max.y, kFacadeTexelsPerUnit);
+        atlasW = std::max(atlasW, 2 * (charts[i].nx + charts[i].nz));
+        order[i] = i;
+    }
+    // shelf packing below the ground chart, tallest first
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return charts[a].rows > charts[b].rows; });
+    int x = 0, y = groundNz, shelf = 0;
+    for (size_t i : order) {
+        FacadeChart& c = charts[i];
+        int w = 2 * (c.nx + c.nz);
+        if (x + w > atlasW) { y += shelf; x = 0; shelf = 0; }
+        c.atlasX = x;
+        c.atlasY = y;
+        x += w;
+        shelf = std::max(shelf, c.rows);
+    }
+    atlasH = y + shelf;
+}
+
+void Lightmap::bake(const LightmapInputs& in) {
+    layoutCharts(in);
+    texels.assign((size_t)atlasW * atlasH * 3, 0);
+
+    BVH occluders;
+    occluders.build(in.occluders, &WorkerPool::shared());
+
+    // cosine-weighted, stratified hemisphere directions around +z; rotated per texel
+    glm::vec3 pattern[kAmbientRays];
+    const int strata = (int)std::sqrt((float)kAmbientRays);
+    for (int k = 0; k < kAmbientRays; k++) {
+        float u = ((k % strata) + 0.5f) / strata, v = ((k / strata) + 0.5f) / strata;
+        float r = std::sqrt(u), phi = v * 6.2831853f;
+        pattern[k] = glm::vec3(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::max(0.0f, 1.0f - u)));
+    }
+
+    // irradiance at one surface point; `self` is the building the point lies on, or -1
+    auto irradiance = [&](const glm::vec3& surface, const glm::vec3& n, int self, const std::vector<int>& rowLights,
+                          uint32_t tx, uint32_t ty) {
+        glm::vec3 p = surface + n * kSurfaceOffset;
+        glm::vec3 e(0.0f);
+        for (int l : rowLights) {
+            const PointLight& light = in.lights[l];
+            glm::vec3 lv = light.position - p;
+            float d = glm::length(lv);
+            if (d >= light.radius) continue;
+            float diff = glm::dot(n, lv) / std::max(d, 1e-4f);
+            if (diff <= 0.0f) continue;
+            int owner = (size_t)l < in.lightOwners.size() ? in.lightOwners[l] : -1;
+            if (occluders.occluded(p, light.position, self, owner)) continue;
+            float ratio = d / light.radius;
+            float window = glm::clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+            e += light.color * (light.intensity * diff * window * window / (1.0f + d * d));
+        }
+        // sky visibility; the ground plane (no box of its own) blocks downward rays
+        glm::vec3 t = std::fabs(n.y) < 0.9f ? glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), n))
+                                            : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 b = glm::cross(n, t);
+        float rot = hashAngle(tx, ty), cr = std::cos(rot), sr = std::sin(rot);
+        int open = 0;
+        for (int k = 0; k < kAmbientRays; k++) {
+            glm::vec3 s = pattern[k];
+            glm::vec3 dir = t * (s.x * cr - s.y * sr) + b * (s.x * sr + s.y * cr) + n * s.z;
+            if (dir.y < 0.0f && p.y < -dir.y * kAmbientReach) continue;
+            if (!occluders.occluded(p, p + dir * kAmbientReach, self)) open++;
+        }
+        return e + glm::vec3(kAmbient * open / kAmbientRays);
+    };
+    auto store = [&](int x, int y, const glm::vec3& e) {
+        uint16_t* out = &texels[((size_t)y * atlasW + x) * 3];
+        out[0] = glm::packHalf1x16(e.x);
+        out[1] = glm::packHalf1x16(e.y);
+        out[2] = glm::packHalf1x16(e.z);
+    };
+
+    // one job per chart row: (chart, row), chart -1 = ground
+    std::vector<std::pair<int, int>> jobs;
+    for (int j = 0; j < groundNz; j++) jobs.push_back({ -1, j });
+    for (size_t c = 0; c < charts.size(); c++)
+        for (int r = 0; r < charts[c].rows; r++) jobs.push_back({ (int)c, r });
+
+    WorkerPool::shared().parallelFor(jobs.size(), [&](size_t begin, size_t end) {
+        std::vector<int> rowLights;
+        for (size_t job = begin; job < end; job++) {
+            int c = jobs[job].first, row = jobs[job].second;
+            rowLights.clear();
+            if (c < 0) {
+                float z = groundMin.y + (groundMax.y - groundMin.y) * row / (groundNz - 1);
+                for (size_t l = 0; l < in.lights.size(); l++)
+                    if (std::fabs(in.lights[l].position.z - z) < in.lights[l].radius) rowLights.push_back((int)l);
+                for (int i = 0; i < groundNx; i++) {
+                    float x = groundMin.x + (groundMax.x - groundMin.x) * i / (groundNx - 1);
+                    store(i, row, irradiance(glm::vec3(x, 0.0f, z), glm::vec3(0.0f, 1.0f, 0.0f), -1, rowLights, i, row));
+                }
+                continue;
+            }
+            const AABB& bb = buildings[c];
+            const FacadeChart& ch = charts[c];
+            float y = bb.max.y * row / (ch.rows - 1);
+            // lights reaching this row somewhere on the building's perimeter
+            for (size_t l = 0; l < in.lights.size(); l++) {
+                const glm::vec3& lp = in.lights[l].position;
+                float dx = std::max(std::max(bb.min.x - lp.x, lp.x - bb.max.x), 0.0f);
+                float dz = std::max(std::max(bb.min.z - lp.z, lp.z - bb.max.z), 0.0f);
+                float dy = lp.y - y, r = in.lights[l].radius;
+                if (dx * dx + dy * dy + dz * dz < r * r) rowLights.push_back((int)l);
+            }
+            // sides in atlas order: +x, +z, -x, -z (u runs along +z or +x on each)
+            int start = 0;
+            for (int face = 0; face < 4; face++) {
+                bool alongZ = (face % 2) == 0;
+                int n = alongZ ? ch.nz : ch.nx;
+                for (int i = 0; i < n; i++) {
+                    float u = (float)i / (n - 1);
+                    glm::vec3 p, normal;
+                    if (alongZ) {
+                        float side = face == 0 ? 1.0f : -1.0f;
+                        p = glm::vec3(face == 0 ? bb.max.x : bb.min.x, y, bb.min.z + u * (bb.max.z - bb.min.z));
+                        normal = glm::vec3(side, 0.0f, 0.0f);
+                    } else {
+                        float side = face == 1 ? 1.0f : -1.0f;
+                        p = glm::vec3(bb.min.x + u * (bb.max.x - bb.min.x), y, face == 1 ? bb.max.z : bb.min.z);
+                        normal = glm::vec3(0.0f, 0.0f, side);
+                    }
+                    int ax = ch.atlasX + start + i, ay = ch.atlasY + row;
+                    store(ax, ay, irradiance(p, normal, c, rowLights, ax, ay));
+                }
+                start += n;
+            }
+        }
+    }, 4);
+}
+
+bool Lightmap::load(const std::string& path, uint64_t key) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    CacheHeader h;
+    if (!in.read((char*)&h, sizeof(h)) || memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || h.key != key)
+        return false;
+    if (h.atlasW <= 0 || h.atlasH <= 0 || h.atlasW > 16384 || h.atlasH > 16384) return false;
+    std::vector<AABB> b(h.chartCount);
+    std::vector<FacadeChart> c(h.chartCount);
+    std::vector<uint16_t> t((size_t)h.atlasW * h.atlasH * 3);
+    if (!in.read((char*)b.data(), b.size() * sizeof(AABB)) || !in.read((char*)c.data(), c.size() * sizeof(FacadeChart)) ||
+        !in.read((char*)t.data(), t.size() * sizeof(uint16_t)))
+        return false;
+    atlasW = h.atlasW; atlasH = h.atlasH;
+    groundNx = h.groundNx; groundNz = h.groundNz;
+    groundMin = glm::vec2(h.groundMin[0], h.groundMin[1]);
+    groundMax = glm::vec2(h.groundMax[0], h.groundMax[1]);
+    buildings.swap(b);
+    charts.swap(c);
+    texels.swap(t);
+    return true;
+}
+
+bool Lightmap::save(const std::string& path, uint64_t key) const {
+    CacheHeader h;
+    memset(&h, 0, sizeof(h)); // padding too, so equal bakes give byte-identical files
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.key = key;
+    h.atlasW = atlasW; h.atlasH = atlasH;
+    h.groundNx = groundNx; h.groundNz = groundNz;
+    h.groundMin[0] = groundMin.x; h.groundMin[1] = groundMin.y;
+    h.groundMax[0] = groundMax.x; h.groundMax[1] = groundMax.y;
+    h.chartCount = (uint32_t)charts.size();
+    return writeFileAtomic(path, [&](std::ostream& out) {
+        out.write((const char*)&h, sizeof(h));
+        out.write((const char*)buildings.data(), buildings.size() * sizeof(AABB));
+        out.write((const char*)charts.data(), charts.size() * sizeof(FacadeChart));
+        out.write((const char*)texels.data(), texels.size() * sizeof(uint16_t));
+        return (bool)out;
+    });
+}
+
+void Lightmap::upload() {
+    if (texels.empty()) return;
+    if (!atlasTex) glGenTextures(1, &atlasTex);
+    glBindTexture(GL_TEXTURE_2D, atlasTex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2); // rows of 3 halves per texel
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, atlasW, atlasH, 0, GL_RGB, GL_HALF_FLOAT, texels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // 3 texels per building: bounds (min x/z, max x/z), atlas origin + rows + height, side widths
+    std::vector<float> table;
+    for (size_t i = 0; i < charts.size(); i++) {
+        const AABB& b = buildings[i];
+        const FacadeChart& c = charts[i];
+        float t[12] = { b.min.x, b.min.z, b.max.x, b.max.z,
+                        (float)c.atlasX, (float)c.atlasY, (float)c.rows, b.max.y,
+                        (float)c.nx, (float)c.nz, 0.0f, 0.0f };
+        table.insert(table.end(), t, t + 12);
+    }
+    if (!chartBuf) {
+        glGenBuffers(1, &chartBuf);
+        glGenTextures(1, &chartTex);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, chartBuf);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(table.size() * sizeof(float), 16), NULL, GL_STATIC_DRAW);
+    if (!table.empty()) glBufferSubData(GL_TEXTURE_BUFFER, 0, table.size() * sizeof(float), table.data());
+    glBindTexture(GL_TEXTURE_BUFFER, chartTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, chartBuf);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void Lightmap::bind(const Shader& shader, int firstUnit, bool enabled) const {
+    glActiveTexture(GL_TEXTURE0 + firstUnit);
+    glBindTexture(GL_TEXTURE_2D, atlasTex);
+    shader.setInt("lightmap", firstUnit);
+    glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+    glBindTexture(GL_TEXTURE_BUFFER, chartTex);
+    shader.setInt("lightmapCharts", firstUnit + 1);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("lightmapBuildings", (enabled && atlasTex) ? (int)charts.size() : -1);
+    shader.setVec4("lightmapGround", glm::vec4(groundMin.x, groundMin.y, groundMax.x, groundMax.y));
+    shader.setIVec2("lightmapGroundSize", groundNx, groundNz);
+}
+
+glm::vec3 Lightmap::texel(int x, int y) const {
+    const uint16_t* t = &texels[((size_t)y * atlasW + x) * 3];
+    return glm::vec3(glm::unpackHalf1x16(t[0]), glm::unpackHalf1x16(t[1]), glm::unpackHalf1x16(t[2]));
+}
+
+glm::vec3 Lightmap::sampleGround(float x, float z) const {
+    float fx = glm::clamp((x - groundMin.x) / (groundMax.x - groundMin.x), 0.0f, 1.0f) * (groundNx - 1);
+    float fz = glm::clamp((z - groundMin.y) / (groundMax.y - groundMin.y), 0.0f, 1.0f) * (groundNz - 1);
+    int x0 = std::min((int)fx, groundNx - 2), z0 = std::min((int)fz, groundNz - 2);
+    float ax = fx - x0, az = fz - z0;
+    return glm::mix(glm::mix(texel(x0, z0), texel(x0 + 1, z0), ax),
+                    glm::mix(texel(x0, z0 + 1), texel(x0 + 1, z0 + 1), ax), az);
+}
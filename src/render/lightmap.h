@@ -0,0 +1,78 @@
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "frustum.h"
+#include "light_clusters.h"
+#include "shader.h"
+
+// Static geometry and lights seen by the lightmap baker
+struct LightmapInputs {
+    std::vector<AABB> occluders;    // static object bounds; the first buildingCount also get facade charts
+    size_t buildingCount = 0;
+    std::vector<PointLight> lights; // lights to bake
+    std::vector<int> lightOwners;   // occluder index of each light's own fixture (casts no shadow for it), or -1
+    glm::vec2 groundMin = glm::vec2(0.0f), groundMax = glm::vec2(0.0f); // ground + roads, top-down at y = 0
+};
+
+// Baked night lighting: ambient sky visibility plus direct light from static lamps, as
+// irradiance (multiplied by the surface color in the shader). One RGB16F atlas holds a
+// top-down chart for the ground and roads, then per building its four bounding-box
+// sides unrolled next to each other. Texel centers sit on the chart edges, so bilinear
+// filtering never reads a neighbouring chart. Shadows and ambient occlusion are ray
+// cast against a BVH over the static object bounds. Facade vertices carry their
+// building's chart index (GeometryArena), so a lookup is a fixed number of fetches.
+class Lightmap {
+public:
+    static const int kGroundTexelsPerUnit = 4;
+    static const int kFacadeTexelsPerUnit = 2;
+    static const int kAmbientRays = 16;
+    static const int kAtlasWidth = 1024; // at least; wider if the ground chart needs it
+
+    Lightmap() {}
+    ~Lightmap();
+    Lightmap(const Lightmap&) = delete;
+    Lightmap& operator=(const Lightmap&) = delete;
+
+    // Hash of everything the bake depends on; names the cache entry for a layout
+    static uint64_t layoutKey(const LightmapInputs& in);
+    // Multithreaded CPU bake (parallel over atlas rows)
+    void bake(const LightmapInputs& in);
+    // Cache entries carry the layout key; false if missing, stale or corrupt
+    bool load(const std::string& path, uint64_t key);
+    bool save(const std::string& path, uint64_t key) const;
+
+    void upload();
+    // Binds the atlas and chart table to units firstUnit, firstUnit+1; with no lightmap
+    // (or enabled = false) the shader falls back to per-pixel lamp lighting
+    void bind(const Shader& shader, int firstUnit, bool enabled = true) const;
+
+    bool empty() const { return texels.empty(); }
+    int width() const { return atlasW; }
+    int height() const { return atlasH; }
+    glm::vec3 texel(int x, int y) const;
+    // Irradiance at a ground point, bilinear like the shader
+    glm::vec3 sampleGround(float x, float z) const;
+private:
+    // one chart per building: atlas origin, texels along x / z sides, rows up to the roof
+    struct FacadeChart {
+        int atlasX = 0, atlasY = 0;
+        int nx = 0, nz = 0, rows = 0;
+    };
+    int atlasW = 0, atlasH = 0;
+    int groundNx = 0, groundNz = 0; // ground chart at (0, 0)
+    glm::vec2 groundMin = glm::vec2(0.0f), groundMax = glm::vec2(0.0f);
+    std::vector<AABB> buildings;
+    std::vector<FacadeChart> charts;
+    std::vector<uint16_t> texels; // half floats, rgb
+
+    GLuint atlasTex = 0, chartBuf = 0, chartTex = 0;
+
+    void layoutCharts(const LightmapInputs& in);
+};
+
+#endif // LIGHTMAP_H
@@ -0,0 +1,158 @@
+#include "occlusion_buffer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float kMinW = 1e-3f; // corners closer than this (or behind the eye) are not projected
+const int kMaxSpan = 8;    // occludee rects are tested on the finest level where they span <= 8x8 texels
+
+// corner c of a box: bit 0 = x, bit 1 = y, bit 2 = z
+glm::vec3 corner(const AABB& b, int c) {
+    return glm::vec3((c & 1) ? b.max.x : b.min.x, (c & 2) ? b.max.y : b.min.y, (c & 4) ? b.max.z : b.min.z);
+}
+
+// box faces as corner quads, paired with the axis/side they face
+const int kFaces[6][4] = {
+    {0, 4, 6, 2}, {1, 3, 7, 5}, // -x, +x
+    {0, 1, 5, 4}, {2, 6, 7, 3}, // -y, +y
+    {0, 2, 3, 1}, {4, 5, 7, 6}, // -z, +z
+};
+
+} // namespace
+
+void OcclusionBuffer::begin(const glm::mat4& vp, const glm::vec3& eyePos, int width, int height) {
+    viewProj = vp;
+    eye = eyePos;
+    occluders = 0;
+    width = std::max(1, width);
+    height = std::max(1, height);
+    if (levelW.empty() || levelW[0] != width || levelH[0] != height) {
+        levels.clear(); levelW.clear(); levelH.clear();
+        int w = width, h = height;
+        while (true) {
+            levels.push_back(std::vector<float>((size_t)w * h));
+            levelW.push_back(w);
+            levelH.push_back(h);
+            if (w == 1 && h == 1) break;
+            w = std::max(1, (w + 1) / 2);
+            h = std::max(1, (h + 1) / 2);
+        }
+    }
+    std::fill(levels[0].begin(), levels[0].end(), 1.0f);
+}
+
+void OcclusionBuffer::addOccluder(const AABB& box) {
+    // project corners to (pixel x, pixel y, ndc z); near-clipped occluders are skipped
+    // rather than clipped, which only loses some culling
+    glm::vec3 screen[8];
+    float w0 = (float)levelW[0], h0 = (float)levelH[0];
+    for (int c = 0; c < 8; c++) {
+        glm::vec4 clip = viewProj * glm::vec4(corner(box, c), 1.0f);
+        if (clip.w < kMinW) return;
+        float inv = 1.0f / clip.w;
+        screen[c] = glm::vec3((clip.x * inv * 0.5f + 0.5f) * w0, (clip.y * inv * 0.5f + 0.5f) * h0, clip.z * inv);
+    }
+    occluders++;
+    bool facing[6] = {
+        eye.x < box.min.x, eye.x > box.max.x,
+        eye.y < box.min.y, eye.y > box.max.y,
+        eye.z < box.min.z, eye.z > box.max.z,
+    };
+    for (int f = 0; f < 6; f++) {
+        if (!facing[f]) continue;
+        const int* q = kFaces[f];
+        rasterQuad(screen[q[0]], screen[q[1]], screen[q[2]], screen[q[3]]);
+    }
+}
+
+void OcclusionBuffer::rasterQuad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+    // the face's depth plane (NDC depth is affine in screen space for a planar face)
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (std::fabs(area) < 1e-6f) return; // edge-on
+    float invArea = 1.0f / area;
+    float dzdx = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) * invArea;
+    float dzdy = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) * invArea;
+    // farthest depth anywhere in a pixel, relative to its center
+    float zSlack = 0.5f * (std::fabs(dzdx) + std::fabs(dzdy));
+
+    // edge functions, positive inside whichever way the quad winds on screen
+    const glm::vec3* p[4] = { &a, &b, &c, &d };
+    float ex[4], ey[4], e0[4];
+    float side = area > 0.0f ? 1.0f : -1.0f;
+    for (int i = 0; i < 4; i++) {
+        const glm::vec3& p0 = *p[i];
+        const glm::vec3& p1 = *p[(i + 1) & 3];
+        ex[i] = -(p1.y - p0.y) * side;
+        ey[i] = (p1.x - p0.x) * side;
+        // at a pixel center, less the most any corner of the pixel can fall below it
+        e0[i] = -(ex[i] * p0.x + ey[i] * p0.y) - 0.5f * (std::fabs(ex[i]) + std::fabs(ey[i]));
+    }
+
+    int w = levelW[0], h = levelH[0];
+    float minX = std::min(std::min(a.x, b.x), std::min(c.x, d.x)), maxX = std::max(std::max(a.x, b.x), std::max(c.x, d.x));
+    float minY = std::min(std::min(a.y, b.y), std::min(c.y, d.y)), maxY = std::max(std::max(a.y, b.y), std::max(c.y, d.y));
+    int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(w - 1, (int)std::ceil(maxX));
+    int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(h - 1, (int)std::ceil(maxY));
+    std::vector<float>& depth = levels[0];
+
+    // only pixels the face covers completely are written, with the face's farthest depth
+    // inside them, so an occludee is never hidden by a pixel the occluder only grazes
+    for (int y = y0; y <= y1; y++) {
+        float py = y + 0.5f;
+        for (int x = x0; x <= x1; x++) {
+            float px = x + 0.5f;
+            bool covered = true;
+            for (int i = 0; i < 4 && covered; i++) covered = ex[i] * px + ey[i] * py + e0[i] >= 0.0f;
+            if (!covered) continue;
+            float z = a.z + dzdx * (px - a.x) + dzdy * (py - a.y) + zSlack;
+            float& dst = depth[(size_t)y * w + x];
+            if (z < dst) dst = z;
+        }
+    }
+}
+
+void OcclusionBuffer::buildHiZ() {
+    // each texel keeps the farthest depth of the 2x2 texels below it
+    for (size_t l = 1; l < levels.size(); l++) {
+        const std::vector<float>& src = levels[l - 1];
+        std::vector<float>& dst = levels[l];
+        int sw = levelW[l - 1], sh = levelH[l - 1];
+        for (int y = 0; y < levelH[l]; y++) {
+            int sy0 = std::min(2 * y, sh - 1), sy1 = std::min(2 * y + 1, sh - 1);
+            for (int x = 0; x < levelW[l]; x++) {
+                int sx0 = std::min(2 * x, sw - 1), sx1 = std::min(2 * x + 1, sw - 1);
+                dst[(size_t)y * levelW[l] + x] = std::max(
+                    std::max(src[(size_t)sy0 * sw + sx0], src[(size_t)sy0 * sw + sx1]),
+                    std::max(src[(size_t)sy1 * sw + sx0], src[(size_t)sy1 * sw + sx1]));
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::visible(const AABB& box) const {
+    if (levels.empty() || occluders == 0) return true;
+    float w0 = (float)levelW[0], h0 = (float)levelH[0];
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+    for (int c = 0; c < 8; c++) {
+        glm::vec4 clip = viewProj * glm::vec4(corner(box, c), 1.0f);
+        if (clip.w < kMinW) return true; // straddles the near plane
+        float inv = 1.0f / clip.w;
+        float sx = (clip.x * inv * 0.5f + 0.5f) * w0, sy = (clip.y * inv * 0.5f + 0.5f) * h0;
+        minX = std::min(minX, sx); maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy); maxY = std::max(maxY, sy);
+        minZ = std::min(minZ, clip.z * inv);
+    }
+    int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(levelW[0] - 1, (int)std::floor(maxX));
+    int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(levelH[0] - 1, (int)std::floor(maxY));
+    if (x0 > x1 || y0 > y1) return true; // off screen: leave it to frustum culling
+
+    // finest level where the rect stays within kMaxSpan texels per axis
+    size_t l = 0;
+    while (l + 1 < levels.size() && ((x1 >> l) - (x0 >> l) >= kMaxSpan || (y1 >> l) - (y0 >> l) >= kMaxSpan)) l++;
+    const std::vector<float>& hiz = levels[l];
+    for (int y = y0 >> l; y <= (y1 >> l); y++)
+        for (int x = x0 >> l; x <= (x1 >> l); x++)
+            if (minZ <= hiz[(size_t)y * levelW[l] + x]) return true;
+    return false;
+}
@@ -0,0 +1,36 @@
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include "frustum.h"
+#include <vector>
+
+// Low-resolution software depth buffer for occlusion culling. Occluder boxes are
+// rasterized on the CPU (no GPU readback, so it also works on software GL such as
+// llvmpipe) into only the pixels they fully cover, at their farthest depth there,
+// reduced into a max-depth mip pyramid (Hi-Z), and object bounds are
+// tested against the pyramid level where their screen rect covers at most 8x8 texels.
+class OcclusionBuffer {
+public:
+    // Clears the buffer for a new view; eye is used to skip faces pointing away
+    void begin(const glm::mat4& viewProj, const glm::vec3& eye, int width, int height);
+    // Occluders must be solid: every pixel they cover is treated as opaque
+    void addOccluder(const AABB& box);
+    void buildHiZ();
+    // False only if the box is certainly hidden behind the rasterized occluders
+    bool visible(const AABB& box) const;
+
+    int width() const { return levelW.empty() ? 0 : levelW[0]; }
+    int height() const { return levelH.empty() ? 0 : levelH[0]; }
+    int occluderCount() const { return occluders; }
+private:
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    glm::vec3 eye = glm::vec3(0.0f);
+    std::vector<std::vector<float>> levels; // [0] = full res, NDC depth, 1 = far
+    std::vector<int> levelW, levelH;
+    int occluders = 0;
+
+    // one convex box face, conservatively: full pixel coverage, farthest depth per pixel
+    void rasterQuad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d);
+};
+
+#endif // OCCLUSION_BUFFER_H
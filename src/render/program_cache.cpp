@@ -0,0 +1,123 @@
+#include "program_cache.h"
+#include "../core/atomic_file.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const char kMagic[4] = {'G', 'V', 'P', 'B'};
+
+struct BinaryHeader {
+    char magic[4];
+    uint32_t format;
+    uint32_t length;
+};
+
+uint64_t fnv1a(const std::string& s, uint64_t h = 14695981039346656037ull) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string glString(GLenum name) {
+    const GLubyte* s = glGetString(name);
+    return s ? std::string((const char*)s) : std::string();
+}
+
+} // namespace
+
+ProgramBinaryCache& ProgramBinaryCache::shared() {
+    static ProgramBinaryCache cache;
+    return cache;
+}
+
+void ProgramBinaryCache::enable(const std::string& directory) {
+    active = false;
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) {
+        std::cout << "Program binary cache unavailable (no ARB_get_program_binary)\n";
+        return;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+        std::cout << "Program binary cache unavailable (driver reports no binary formats)\n";
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        std::cerr << "Program binary cache disabled: cannot create " << directory << "\n";
+        return;
+    }
+    dir = directory;
+    driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+    active = true;
+}
+
+std::string ProgramBinaryCache::keyFor(const std::string& vertexSrc, const std::string& fragmentSrc) const {
+    uint64_t h = fnv1a(driver);
+    h = fnv1a(vertexSrc, h ^ 0x76ull);  // seed per stage so swapped sources hash differently
+    h = fnv1a(fragmentSrc, h ^ 0x66ull);
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+    return buf;
+}
+
+std::string ProgramBinaryCache::pathFor(const std::string& key) const {
+    return dir + "/" + key + ".bin";
+}
+
+bool ProgramBinaryCache::load(GLuint program, const std::string& key) const {
+    if (!active) return false;
+    std::ifstream in(pathFor(key), std::ios::binary);
+    if (!in) return false;
+    BinaryHeader header;
+    if (!in.read((char*)&header, sizeof(header)) || memcmp(header.magic, kMagic, 4) != 0 || header.length == 0)
+        return false;
+    std::vector<char> data(header.length);
+    if (!in.read(data.data(), data.size())) return false;
+
+    glProgramBinary(program, header.format, data.data(), (GLsizei)data.size());
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        // driver changed in a way the version string didn't show; drop the stale entry
+        std::cout << "Cached program binary " << key << " rejected, recompiling\n";
+        std::remove(pathFor(key).c_str());
+        return false;
+    }
+    return true;
+}
+
+void ProgramBinaryCache::prepare(GLuint program) const {
+    if (active) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramBinaryCache::store(GLuint program, const std::string& key) const {
+    if (!active) return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<char> data(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, data.data());
+    if (written <= 0) return;
+
+    BinaryHeader header;
+    memcpy(header.magic, kMagic, 4);
+    header.format = format;
+    header.length = (uint32_t)written;
+    writeFileAtomic(pathFor(key), [&](std::ostream& out) {
+        out.write((const char*)&header, sizeof(header));
+        out.write(data.data(), written);
+        return (bool)out;
+    });
+}
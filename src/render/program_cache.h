@@ -0,0 +1,31 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+#include <string>
+
+// On-disk cache of linked program binaries (GL 4.1 / ARB_get_program_binary).
+// Entries are keyed by a hash of the full shader sources plus the driver's
+// vendor/renderer/version strings, so a driver update simply misses the cache.
+class ProgramBinaryCache {
+public:
+    static ProgramBinaryCache& shared();
+
+    // Needs a current context; stays disabled if the driver exposes no binary formats
+    void enable(const std::string& directory);
+    bool enabled() const { return active; }
+
+    std::string keyFor(const std::string& vertexSrc, const std::string& fragmentSrc) const;
+    // Links `program` from a cached binary; false if missing or rejected by the driver
+    bool load(GLuint program, const std::string& key) const;
+    // Call before glLinkProgram so the driver keeps a retrievable binary
+    void prepare(GLuint program) const;
+    void store(GLuint program, const std::string& key) const;
+private:
+    bool active = false;
+    std::string dir;
+    std::string driver; // vendor/renderer/version, folded into every key
+    std::string pathFor(const std::string& key) const;
+};
+
+#endif // PROGRAM_CACHE_H
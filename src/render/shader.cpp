@@ -1,44 +1,156 @@
 #include "shader.h"
+#include "program_cache.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
 #include <glm/gtc/type_ptr.hpp>
 
-Shader::Shader(const char* vsrc, const char* fsrc) {
-    GLuint vs = compile(GL_VERTEX_SHADER, vsrc);
-    GLuint fs = compile(GL_FRAGMENT_SHADER, fsrc);
+glm::mat3 normalMatrix(const glm::mat4& model) {
+    glm::mat3 m(model);
+    float sx = glm::dot(m[0], m[0]), sy = glm::dot(m[1], m[1]), sz = glm::dot(m[2], m[2]);
+    float eps = 1e-4f * std::max(sx, std::max(sy, sz));
+    bool uniform = std::fabs(sx - sy) <= eps && std::fabs(sx - sz) <= eps &&
+                   std::fabs(glm::dot(m[0], m[1])) <= eps && std::fabs(glm::dot(m[0], m[2])) <= eps &&
+                   std::fabs(glm::dot(m[1], m[2])) <= eps;
+    if (uniform) return m; // rotation * uniform scale: same directions as the inverse-transpose
+    return glm::transpose(glm::inverse(m));
+}
+
+bool readShaderFile(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open shader file " << path << "\n";
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+// inserts "#define NAME" lines after the #version directive (which must stay first)
+static std::string withDefines(const char* src, const std::vector<std::string>& defines) {
+    std::string s(src);
+    if (defines.empty()) return s;
+    std::string block;
+    for (auto& d : defines) block += "#define " + d + "\n";
+    size_t at = 0;
+    size_t version = s.find("#version");
+    if (version != std::string::npos) {
+        size_t eol = s.find('\n', version);
+        at = (eol == std::string::npos) ? s.size() : eol + 1;
+    }
+    return s.insert(at, block);
+}
+
+static bool parallelCompile = false;
+
+bool Shader::enableParallelCompile() {
+    parallelCompile = GLEW_KHR_parallel_shader_compile != 0;
+    if (parallelCompile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu); // driver picks the count
+    return parallelCompile;
+}
+
+bool Shader::parallelCompileEnabled() { return parallelCompile; }
+
+Shader::Shader(const char* vsrc, const char* fsrc, const std::vector<std::string>& defines, bool deferFinish) {
+    uniformScale = std::find(defines.begin(), defines.end(), "UNIFORM_SCALE") != defines.end();
+    std::string vfull = withDefines(vsrc, defines), ffull = withDefines(fsrc, defines);
     id = glCreateProgram();
-    glAttachShader(id, vs);
-    glAttachShader(id, fs);
+
+    // warm start: link straight from the driver binary cached by an earlier run
+    const ProgramBinaryCache& cache = ProgramBinaryCache::shared();
+    if (cache.enabled()) {
+        cacheKey = cache.keyFor(vfull, ffull);
+        if (cache.load(id, cacheKey)) {
+            fromCache = true;
+            return;
+        }
+        glDeleteProgram(id); // a rejected binary leaves the program unusable
+        id = glCreateProgram();
+    }
+
+    pendingVs = compile(GL_VERTEX_SHADER, vfull.c_str());
+    pendingFs = compile(GL_FRAGMENT_SHADER, ffull.c_str());
+    glAttachShader(id, pendingVs);
+    glAttachShader(id, pendingFs);
+    cache.prepare(id);
     glLinkProgram(id);
+    if (!deferFinish) finish();
+}
+
+Shader::~Shader() {
+    if (pendingVs) glDeleteShader(pendingVs);
+    if (pendingFs) glDeleteShader(pendingFs);
+    if (id) glDeleteProgram(id);
+}
+
+bool Shader::completed() const {
+    if (!pending() || !parallelCompile) return true;
+    GLint done = GL_FALSE;
+    glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+bool Shader::finish() {
+    if (!pending()) {
+        GLint ok = GL_FALSE;
+        if (id) glGetProgramiv(id, GL_LINK_STATUS, &ok);
+        return ok == GL_TRUE;
+    }
+    // compile logs are only read here, after the link, so nothing above forced a sync
+    GLuint stages[2] = { pendingVs, pendingFs };
+    for (GLuint st : stages) {
+        GLint ok; glGetShaderiv(st, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char buf[1024]; glGetShaderInfoLog(st, 1024, NULL, buf);
+            std::cerr << "Shader compile error: " << buf << "\n";
+        }
+    }
     GLint ok; glGetProgramiv(id, GL_LINK_STATUS, &ok);
     if (!ok) {
         char buf[1024]; glGetProgramInfoLog(id, 1024, NULL, buf);
         std::cerr << "Shader link error: " << buf << "\n";
+    } else {
+        ProgramBinaryCache::shared().store(id, cacheKey);
     }
-    glDeleteShader(vs); glDeleteShader(fs);
-}
-
-Shader::~Shader() {
-    if (id) glDeleteProgram(id);
+    glDetachShader(id, pendingVs); glDetachShader(id, pendingFs);
+    glDeleteShader(pendingVs); glDeleteShader(pendingFs);
+    pendingVs = pendingFs = 0;
+    return ok == GL_TRUE;
 }
 
 GLuint Shader::compile(GLenum type, const char* src) {
     GLuint s = glCreateShader(type);
     glShaderSource(s, 1, &src, NULL);
-    glCompileShader(s);
-    GLint ok; glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
-    if (!ok) {
-        char buf[1024]; glGetShaderInfoLog(s, 1024, NULL, buf);
-        std::cerr << "Shader compile error: " << buf << "\n";
-    }
+    glCompileShader(s); // status is checked in finish()
     return s;
 }
 void Shader::use() const { glUseProgram(id); }
 void Shader::setMat4(const std::string& name, const glm::mat4& m) const {
     glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(m));
 }
+void Shader::setMat3(const std::string& name, const glm::mat3& m) const {
+    glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(m));
+}
+void Shader::setModel(const glm::mat4& model) const {
+    setMat4("model", model);
+    if (!uniformScale) setMat3("normalMatrix", normalMatrix(model));
+}
+void Shader::setVec2(const std::string& name, const glm::vec2& v) const {
+    glUniform2fv(glGetUniformLocation(id, name.c_str()), 1, &v[0]);
+}
+void Shader::setIVec2(const std::string& name, int x, int y) const {
+    glUniform2i(glGetUniformLocation(id, name.c_str()), x, y);
+}
 void Shader::setVec3(const std::string& name, const glm::vec3& v) const {
     glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, &v[0]);
 }
+void Shader::setVec4(const std::string& name, const glm::vec4& v) const {
+    glUniform4fv(glGetUniformLocation(id, name.c_str()), 1, &v[0]);
+}
 void Shader::setFloat(const std::string& name, float v) const {
     glUniform1f(glGetUniformLocation(id, name.c_str()), v);
 }
@@ -2,21 +2,59 @@
 #define SHADER_H
 
 #include <string>
+#include <vector>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Normal matrix for a model transform: plain mat3(model) when the scale is uniform
+// (normals are renormalized per fragment), inverse-transpose otherwise
+glm::mat3 normalMatrix(const glm::mat4& model);
+
+// Reads a whole shader source file; false (with a message) if it can't be opened
+bool readShaderFile(const std::string& path, std::string& out);
+
 class Shader {
 public:
     GLuint id = 0;
+    bool uniformScale = false; // built with UNIFORM_SCALE: normals use mat3(model), no normalMatrix uniform
+    bool fromCache = false;    // linked from ProgramBinaryCache instead of compiled
     Shader() {}
-    Shader(const char* vsrc, const char* fsrc);
+    // defines are injected as "#define NAME" lines right after the #version line.
+    // With deferFinish the compile and link are only submitted: no status is queried
+    // until finish(), so the driver can work on several programs at once.
+    Shader(const char* vsrc, const char* fsrc, const std::vector<std::string>& defines = std::vector<std::string>(),
+           bool deferFinish = false);
     ~Shader();
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    // Asks the driver for as many compiler threads as it likes (KHR_parallel_shader_compile);
+    // returns false if the extension is missing
+    static bool enableParallelCompile();
+    static bool parallelCompileEnabled();
+    // Non-blocking: true once the link has completed (always true without the extension)
+    bool completed() const;
+    // Blocks for the link result, prints errors and fills the binary cache; returns link status
+    bool finish();
+    bool pending() const { return pendingVs != 0 || pendingFs != 0; }
     void use() const;
     void setMat4(const std::string& name, const glm::mat4& m) const;
+    void setMat3(const std::string& name, const glm::mat3& m) const;
+    // Sets "model" and, unless this is a UNIFORM_SCALE variant, its "normalMatrix"
+    void setModel(const glm::mat4& model) const;
+    void setVec2(const std::string& name, const glm::vec2& v) const;
     void setVec3(const std::string& name, const glm::vec3& v) const;
+    void setVec4(const std::string& name, const glm::vec4& v) const;
+    void setIVec2(const std::string& name, int x, int y) const;
     void setFloat(const std::string& name, float v) const;
     void setInt(const std::string& name, int v) const;
 private:
+    GLuint pendingVs = 0, pendingFs = 0; // shader objects awaiting finish()
+    std::string cacheKey;
     GLuint compile(GLenum type, const char* src);
 };
 
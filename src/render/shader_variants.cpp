@@ -0,0 +1,99 @@
+#include "shader_variants.h"
+#include <algorithm>
+#include <iostream>
+
+static const char* kFeatureNames[kShaderFeatureCount] = {
+    "TEXTURED", "INSTANCED", "WATER", "EMISSIVE", "UNIFORM_SCALE", "GBUFFER", "LIGHT_PASS", "LIGHTMAPPED", "DEPTH_ONLY",
+};
+
+ShaderVariants::ShaderVariants(const std::string& n, const char* vertexSrc, const char* fragmentSrc)
+    : name(n), vertexSource(vertexSrc), fragmentSource(fragmentSrc) {}
+
+std::vector<std::string> ShaderVariants::defines(unsigned features) {
+    std::vector<std::string> out;
+    for (int f = 0; f < kShaderFeatureCount; f++)
+        if (features & (1u << f)) out.push_back(kFeatureNames[f]);
+    return out;
+}
+
+std::string ShaderVariants::variantName(unsigned features) const {
+    std::string s = name + "[";
+    std::vector<std::string> d = defines(features);
+    for (size_t i = 0; i < d.size(); i++) s += (i ? "|" : "") + d[i];
+    return s + "]";
+}
+
+void ShaderVariants::finishVariant(unsigned features, Shader& shader) {
+    bool compiled = shader.pending();
+    shader.finish();
+    std::cout << (compiled ? "Compiled shader variant " : "Loaded cached shader variant ") << variantName(features) << "\n";
+}
+
+const Shader& ShaderVariants::get(unsigned features) {
+    auto it = variants.find(features);
+    if (it != variants.end()) {
+        if (it->second->pending()) {
+            finishVariant(features, *it->second);
+            submitted.erase(std::find(submitted.begin(), submitted.end(), features));
+        }
+        return *it->second;
+    }
+    std::unique_ptr<Shader> s(new Shader(vertexSource.c_str(), fragmentSource.c_str(), defines(features), true));
+    finishVariant(features, *s);
+    return *variants.emplace(features, std::move(s)).first->second;
+}
+
+void ShaderVariants::submit(const std::vector<unsigned>& featureSets) {
+    for (unsigned f : featureSets) {
+        if (variants.count(f)) continue;
+        std::unique_ptr<Shader> s(new Shader(vertexSource.c_str(), fragmentSource.c_str(), defines(f), true));
+        variants.emplace(f, std::move(s));
+        submitted.push_back(f);
+    }
+}
+
+void ShaderVariants::reload(const std::string& vertexSrc, const std::string& fragmentSrc) {
+    vertexSource = vertexSrc;
+    fragmentSource = fragmentSrc;
+    reloading.clear(); // an edit made while compiling supersedes the previous one
+    reloadQueue.clear();
+    for (auto& v : variants) {
+        // without KHR_parallel_shader_compile submitting compiles and links on the spot,
+        // so poll() submits these one at a time instead
+        if (Shader::parallelCompileEnabled())
+            reloading[v.first].reset(new Shader(vertexSource.c_str(), fragmentSource.c_str(), defines(v.first), true));
+        else
+            reloadQueue.push_back(v.first);
+    }
+}
+
+size_t ShaderVariants::poll() {
+    for (size_t i = 0; i < submitted.size();) {
+        Shader& s = *variants[submitted[i]];
+        if (!s.completed()) { i++; continue; }
+        finishVariant(submitted[i], s);
+        submitted.erase(submitted.begin() + i);
+    }
+    // one queued reload per call: its compile and link block this frame only
+    if (!reloadQueue.empty()) {
+        unsigned f = reloadQueue.front();
+        reloadQueue.erase(reloadQueue.begin());
+        reloading[f].reset(new Shader(vertexSource.c_str(), fragmentSource.c_str(), defines(f), true));
+    }
+    for (auto it = reloading.begin(); it != reloading.end();) {
+        if (!it->second->completed()) { ++it; continue; }
+        if (it->second->finish()) {
+            std::cout << "Reloaded shader variant " << variantName(it->first) << "\n";
+            variants[it->first] = std::move(it->second);
+        } else {
+            std::cerr << "Keeping previous " << variantName(it->first) << " (reload failed)\n";
+        }
+        it = reloading.erase(it);
+    }
+    return submitted.size() + reloading.size() + reloadQueue.size();
+}
+
+void ShaderVariants::finishAll() {
+    for (unsigned f : submitted) finishVariant(f, *variants[f]);
+    submitted.clear();
+}
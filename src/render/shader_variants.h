@@ -0,0 +1,63 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "shader.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Feature bits of a shader variant; each one is injected as "#define <NAME>"
+enum ShaderFeature : unsigned {
+    SHADER_TEXTURED      = 1u << 0, // color from `tex` instead of baseColor
+    SHADER_INSTANCED     = 1u << 1, // model matrix from per-instance attributes 3..6
+    SHADER_WATER         = 1u << 2, // animated ripples, driven by the `time` uniform
+    SHADER_EMISSIVE      = 1u << 3, // unlit, outputs baseColor
+    SHADER_UNIFORM_SCALE = 1u << 4, // normals via mat3(model), no normalMatrix uniform
+    SHADER_GBUFFER       = 1u << 5, // deferred geometry pass: writes surface attributes, only baked lighting
+    SHADER_LIGHT_PASS    = 1u << 6, // deferred fullscreen pass: lights the G-buffer
+    SHADER_LIGHTMAPPED   = 1u << 7, // static surface: ambient + static lamps from the baked lightmap
+    SHADER_DEPTH_ONLY    = 1u << 8, // shadow map pass: no color output
+};
+const int kShaderFeatureCount = 9;
+
+// One shader source compiled into per-feature-set variants on demand. Variants are
+// cached by their feature mask, which doubles as a sort key for draw ordering.
+class ShaderVariants {
+public:
+    ShaderVariants(const std::string& name, const char* vertexSrc, const char* fragmentSrc);
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // Compiles the variant on first use (or waits for it if it was submitted)
+    const Shader& get(unsigned features);
+    // Starts compiling every listed variant without waiting, so the driver can build
+    // them concurrently while the caller does other work
+    void submit(const std::vector<unsigned>& featureSets);
+    // Rebuilds every variant from new sources. Old programs stay in use until poll()
+    // sees the replacement link; a variant that fails keeps its old program. With
+    // KHR_parallel_shader_compile all variants build in the background; without it,
+    // poll() compiles one variant per call, so each frame stalls for one variant at most.
+    void reload(const std::string& vertexSrc, const std::string& fragmentSrc);
+    // Finishes whatever has completed (swapping in reloaded programs); returns how
+    // many variants are still compiling
+    size_t poll();
+    // Waits for all submitted variants
+    void finishAll();
+    void prepare(const std::vector<unsigned>& featureSets) { submit(featureSets); finishAll(); }
+
+    static std::vector<std::string> defines(unsigned features);
+    // e.g. "scene[TEXTURED|WATER]", for logs
+    std::string variantName(unsigned features) const;
+    size_t size() const { return variants.size(); }
+private:
+    std::string name;
+    std::string vertexSource, fragmentSource;
+    std::map<unsigned, std::unique_ptr<Shader>> variants;
+    std::vector<unsigned> submitted; // variants whose status has not been checked yet
+    std::map<unsigned, std::unique_ptr<Shader>> reloading; // replacements being compiled
+    std::vector<unsigned> reloadQueue; // replacements not submitted yet (no parallel compile)
+    void finishVariant(unsigned features, Shader& shader);
+};
+
+#endif // SHADER_VARIANTS_H
@@ -0,0 +1,133 @@
+#include "shadow_cascades.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+const float ShadowCascades::kSplits[ShadowCascades::kDynamicCascades] = { 15.0f, 60.0f };
+
+ShadowCascades::~ShadowCascades() {
+    if (depthTex) glDeleteTextures(1, &depthTex);
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+}
+
+bool ShadowCascades::create() {
+    glGenTextures(1, &depthTex);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTex);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, kResolution, kResolution, kCascades, 0,
+                 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    // hardware depth compare; LINEAR gives 2x2 PCF per tap
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTex, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!ok) {
+        std::cerr << "Shadow map framebuffer incomplete\n";
+        glDeleteTextures(1, &depthTex); depthTex = 0;
+        glDeleteFramebuffers(1, &fbo); fbo = 0;
+    }
+    return ok;
+}
+
+void ShadowCascades::setLight(const glm::vec3& towardsLight, const AABB& sceneBounds) {
+    glm::vec3 dir = glm::normalize(towardsLight);
+    if (cachedValid && glm::dot(dir, lightDir) > 0.99999f &&
+        sceneBounds.min == bounds.min && sceneBounds.max == bounds.max) return;
+    lightDir = dir;
+    bounds = sceneBounds;
+    cachedValid = false;
+
+    // rotation only, so a texel-aligned offset in light space is texel-aligned everywhere
+    glm::vec3 up = std::fabs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    lightView = glm::lookAt(glm::vec3(0.0f), -dir, up);
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (int c = 0; c < 8; c++) {
+        glm::vec3 p((c & 1) ? bounds.max.x : bounds.min.x, (c & 2) ? bounds.max.y : bounds.min.y,
+                    (c & 4) ? bounds.max.z : bounds.min.z);
+        glm::vec3 q = glm::vec3(lightView * glm::vec4(p, 1.0f));
+        lo = glm::min(lo, q);
+        hi = glm::max(hi, q);
+    }
+    // every cascade uses the full scene depth range, so casters outside a slice still land in it
+    depthNear = -hi.z - 1.0f;
+    depthFar = -lo.z + 1.0f;
+
+    // city cascade: a square around the whole scene
+    int last = kCascades - 1;
+    glm::vec2 center((lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f);
+    float half = std::max(hi.x - lo.x, hi.y - lo.y) * 0.5f + 1.0f;
+    cascadeProj[last] = glm::ortho(center.x - half, center.x + half, center.y - half, center.y + half, depthNear, depthFar);
+    texelWorld[last] = 2.0f * half / kResolution;
+}
+
+void ShadowCascades::fit(const glm::mat4& view, float fovY, float aspect, float zNear) {
+    glm::mat4 invView = glm::inverse(view);
+    float tanY = tanf(fovY * 0.5f), tanX = tanY * aspect;
+    float k2 = tanX * tanX + tanY * tanY; // squared corner offset per unit depth
+    for (int i = 0; i < kDynamicCascades; i++) {
+        float n = (i == 0) ? zNear : kSplits[i - 1], f = kSplits[i];
+        // sphere around the slice, centered on the view axis: its size only depends on
+        // the projection, so rotating the camera never resizes the cascade
+        float c = (n + f) * 0.5f;
+        float radius = std::max(sqrtf((c - n) * (c - n) + n * n * k2), sqrtf((f - c) * (f - c) + f * f * k2));
+        radius = ceilf(radius * 16.0f) / 16.0f;
+        glm::vec3 center = glm::vec3(lightView * (invView * glm::vec4(0.0f, 0.0f, -c, 1.0f)));
+        float texel = 2.0f * radius / kResolution;
+        center.x = floorf(center.x / texel) * texel;
+        center.y = floorf(center.y / texel) * texel;
+        cascadeProj[i] = glm::ortho(center.x - radius, center.x + radius, center.y - radius, center.y + radius,
+                                    depthNear, depthFar);
+        texelWorld[i] = texel;
+    }
+}
+
+void ShadowCascades::beginCascade(int cascade) {
+    if (!inPass) {
+        glGetIntegerv(GL_VIEWPORT, savedViewport);
+        inPass = true;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTex, 0, cascade);
+    glViewport(0, 0, kResolution, kResolution);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+    if (cascade == kCascades - 1) drewCached = true;
+}
+
+void ShadowCascades::end() {
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (inPass) glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+    inPass = false;
+    if (drewCached) cachedValid = true;
+    drewCached = false;
+}
+
+void ShadowCascades::bind(const Shader& shader, int unit, bool enabled) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTex);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("shadowMap", unit);
+    // clip space -> [0,1] texture space
+    glm::mat4 bias = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+    for (int c = 0; c < kCascades; c++) {
+        std::string i = "[" + std::to_string(c) + "]";
+        shader.setMat4("shadowMatrices" + i, bias * lightViewProj(c));
+        shader.setFloat("shadowTexelSize" + i, texelWorld[c]);
+    }
+    shader.setInt("shadowCascades", (enabled && depthTex) ? kCascades : 0);
+    shader.setVec3("lightDir", lightDir);
+}
@@ -0,0 +1,65 @@
+#ifndef SHADOW_CASCADES_H
+#define SHADOW_CASCADES_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "frustum.h"
+#include "shader.h"
+
+// Cascaded shadow maps for a directional light, one layer of a depth texture array
+// per cascade. The first kDynamicCascades follow the camera's view slices and are
+// redrawn every frame with every caster in them; the last one covers the whole city
+// with static casters only and is redrawn only after invalidate() or a light change.
+// Camera-following cascades are fitted to the bounding sphere of their slice (constant
+// size) and snapped to whole texels in light space, so edges don't shimmer as the camera moves.
+class ShadowCascades {
+public:
+    static const int kDynamicCascades = 2;
+    static const int kCascades = kDynamicCascades + 1; // + the cached city cascade
+    static const int kResolution = 1024;
+    static const float kSplits[kDynamicCascades];      // far end of each camera cascade
+
+    ShadowCascades() {}
+    ~ShadowCascades();
+    ShadowCascades(const ShadowCascades&) = delete;
+    ShadowCascades& operator=(const ShadowCascades&) = delete;
+
+    // Needs a GL context; false if the depth array FBO is incomplete
+    bool create();
+    // towardsLight: unit direction to the light. sceneBounds must hold every caster and
+    // receiver; the city cascade is refitted and redrawn when either changes.
+    void setLight(const glm::vec3& towardsLight, const AABB& sceneBounds);
+    void invalidate() { cachedValid = false; }
+    // Whether the city cascade needs drawing this frame
+    bool cachedDirty() const { return !cachedValid; }
+
+    // Fits the camera cascades for this frame (view + symmetric perspective)
+    void fit(const glm::mat4& view, float fovY, float aspect, float zNear);
+    glm::mat4 lightViewProj(int cascade) const { return cascadeProj[cascade] * lightView; }
+    const glm::mat4& view() const { return lightView; }
+    const glm::mat4& projection(int cascade) const { return cascadeProj[cascade]; }
+
+    // Binds one layer for depth rendering (clear, polygon offset); end() restores the
+    // default framebuffer and viewport and marks the city cascade clean if it was drawn
+    void beginCascade(int cascade);
+    void end();
+
+    // Binds the depth array to `unit` and sets the receiver uniforms; enabled = false
+    // (or no shadow map) turns shadows off in the shader
+    void bind(const Shader& shader, int unit, bool enabled = true) const;
+    bool ready() const { return depthTex != 0; }
+private:
+    GLuint fbo = 0, depthTex = 0;
+    glm::vec3 lightDir = glm::vec3(0.0f, 1.0f, 0.0f);
+    AABB bounds;
+    glm::mat4 lightView = glm::mat4(1.0f);
+    glm::mat4 cascadeProj[kCascades];
+    float texelWorld[kCascades] = {}; // world units per shadow texel, for the normal offset
+    float depthNear = 0.0f, depthFar = 1.0f; // light-space depth range of the scene
+    bool cachedValid = false;
+    bool drewCached = false;
+    bool inPass = false;
+    GLint savedViewport[4] = {0, 0, 0, 0};
+};
+
+#endif // SHADOW_CASCADES_H
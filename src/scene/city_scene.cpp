@@ -1,18 +1,92 @@
 #include "city_scene.h"
 #include "../algorithms/algorithms.h"
 #include "../meshes/mesh.h"
+#include "../meshes/road_mesher.h"
+#include "../meshes/building_generator.h"
+#include "../meshes/mesh_optimizer.h"
+#include "../core/worker_pool.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <cstdlib>
 #include <ctime>
 #include <cmath>
 #include <GL/glew.h>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+
+// Buildings smaller than this (fraction of screen height) are drawn as impostors;
+// over the next kImpostorFade the geometry dissolves into the impostor (screen-door)
+static const float kImpostorSize = 0.08f;
+static const float kImpostorFade = 0.03f;
+
+// Spatial index tiles are kTileCells x kTileCells grid cells
+static const int kTileCells = 8;
+
+static const float kFovY = glm::radians(45.0f);
+static const float kNearPlane = 0.1f, kFarPlane = 200.0f;
+
+// shader variants per material
+static const unsigned kPropShader = SHADER_INSTANCED;                           // lit cubes, cached matrices
+static const unsigned kBuildingShader = SHADER_TEXTURED | SHADER_UNIFORM_SCALE; // world-space geometry
+static const unsigned kWaterShader = SHADER_WATER;
+static const unsigned kEmissiveShader = SHADER_EMISSIVE | SHADER_UNIFORM_SCALE; // normals unused
+static const unsigned kEmissivePropShader = kEmissiveShader | SHADER_INSTANCED;
+// static surfaces (ground, roads, buildings) read lamps + ambient from the lightmap
+static const unsigned kGroundShader = SHADER_LIGHTMAPPED; // a scaled cube
+static const unsigned kStaticShader = kBuildingShader | SHADER_LIGHTMAPPED;
+static const unsigned kStaticUntexturedShader = SHADER_UNIFORM_SCALE | SHADER_LIGHTMAPPED;
+static const unsigned kShadowShader = SHADER_DEPTH_ONLY | SHADER_UNIFORM_SCALE;
+static const unsigned kPropShadowShader = kShadowShader | SHADER_INSTANCED;
+
+// Cube parts of the prop kinds, in the object's frame (base center, +x forward). Emissive parts
+// glow and cast no shadow.
+struct PropPart {
+    ObjectKind kind;
+    glm::vec3 offset, scale, color;
+    bool emissive;
+};
+static const PropPart kPropParts[] = {
+    { OBJECT_TREE, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.3f, 2.0f, 0.3f), glm::vec3(0.4f, 0.2f, 0.1f), false }, // Brown trunk
+    { OBJECT_TREE, glm::vec3(0.0f, 2.5f, 0.0f), glm::vec3(1.5f), glm::vec3(0.1f, 0.6f, 0.1f), false },            // Green leaves
+    { OBJECT_LAMP, glm::vec3(0.0f, 2.5f, 0.0f), glm::vec3(0.1f, 5.0f, 0.1f), glm::vec3(0.2f), false },            // Dark metal pole
+    { OBJECT_LAMP, glm::vec3(0.0f, 5.2f, 0.0f), glm::vec3(0.3f, 0.2f, 0.3f), glm::vec3(1.0f, 0.9f, 0.6f), true }, // Warm street light
+    { OBJECT_CAR, glm::vec3(0.0f, 0.4f, 0.0f), glm::vec3(2.0f, 0.8f, 1.0f), glm::vec3(0.8f, 0.1f, 0.1f), false },  // Red car body
+    { OBJECT_CAR, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.6f, 0.4f, 0.8f), glm::vec3(0.7f, 0.1f, 0.1f), false },  // Darker red roof
+    { OBJECT_CAR, glm::vec3(1.1f, 0.5f, 0.3f), glm::vec3(0.1f, 0.2f, 0.2f), glm::vec3(1.0f, 1.0f, 0.9f), true },   // Headlights
+    { OBJECT_CAR, glm::vec3(1.1f, 0.5f, -0.3f), glm::vec3(0.1f, 0.2f, 0.2f), glm::vec3(1.0f, 1.0f, 0.9f), true },
+};
+static const size_t kPropPartCount = sizeof(kPropParts) / sizeof(kPropParts[0]);
+
+static glm::mat4 partMatrix(const PropPart& part) {
+    return glm::scale(glm::translate(glm::mat4(1.0f), part.offset), part.scale);
+}
+
+// moonlight, casting cascaded shadows; camera cascades draw buildings at this LOD
+static const glm::vec3 kTowardsMoon(-0.35f, 1.0f, 0.25f);
+static const int kShadowLod = 1;
+
+// traffic: one car per this much lane length, IDM parameters from TrafficParams
+static const float kTrafficSpacing = 12.0f;
+static const uint32_t kTrafficSeed = 24680;
+
+// baked lightmaps are cached per layout under this directory
+static const char* kLightmapCacheDir = "lightmap_cache";
+
+// software occlusion buffer width (height follows the aspect ratio), and the
+// largest / minimum-size occluders rasterized per frame
+static const int kOcclusionWidth = 256;
+static const int kMaxOccluders = 32;
+static const float kMinOccluderSize = 0.02f;
 
 CityScene::~CityScene() {
-    // cleanup VAOs/buffers in Mesh destructor not implemented; free OpenGL objects
-    if (cubeMesh.vao) { glDeleteVertexArrays(1, &cubeMesh.vao); glDeleteBuffers(1, &cubeMesh.vbo); glDeleteBuffers(1, &cubeMesh.ebo); }
-    if (quadMesh.vao) { glDeleteVertexArrays(1, &quadMesh.vao); glDeleteBuffers(1, &quadMesh.vbo); glDeleteBuffers(1, &quadMesh.ebo); }
-    if (pondMesh.vao) { glDeleteVertexArrays(1, &pondMesh.vao); glDeleteBuffers(1, &pondMesh.vbo); glDeleteBuffers(1, &pondMesh.ebo); }
+    // shared meshes go back to the cache, which frees the GPU buffers on last release
+    meshCache.release(cubeMesh);
+    meshCache.release(quadMesh);
+    meshCache.release(pondMesh);
+    destroyMesh(roadMesh);
     if (buildingTex) glDeleteTextures(1, &buildingTex);
     if (towerTex) glDeleteTextures(1, &towerTex);
     if (skyscraperTex) glDeleteTextures(1, &skyscraperTex);
@@ -47,23 +121,47 @@ bool CityScene::init(int citySize, int numBuildings, int buildingStyle, float to
     
     // meshes
     std::cout << "Creating meshes...\n";
-    cubeMesh = makeCube();
-    quadMesh = makeQuadXZ();
+    cubeMesh = meshCache.cube();
+    quadMesh = meshCache.quadXZ();
     std::cout << "Meshes created\n";
     
     std::cout << "Generating layout...\n";
     generateFuturisticLayout();
     std::cout << "Layout generated\n";
+
+    // road strips (one strip per straight run of cells)
+    auto roadRuns = groupRoadRuns(roadCells);
+    auto origin = cellToWorld(0, 0);
+    roadMesh = makeRoadStrips(roadRuns, origin.first, origin.second);
+    std::cout << "Road mesh created: " << roadRuns.size() << " strips from " << roadCells.size() << " cells\n";
+
+    std::cout << "Generating building geometry...\n";
+    buildBuildingGeometry();
+    std::cout << "Building geometry created (" << buildingArena.vertexCount() << " vertices)\n";
     
-    // pond mesh (world coords)
+    // pond mesh (shared tessellated disc, placed by its transform; waves are animated on the GPU)
     std::cout << "Creating pond mesh...\n";
     auto pondWorld = cellToWorld(pond_cx, pond_cy);
-    pondMesh = makeCircleFan(pondWorld.first, pondWorld.second, (float)pond_r, 64);
-    std::cout << "Pond mesh created\n";
+    pondMesh = meshCache.disc(pondWorld.first, pondWorld.second, (float)pond_r);
+    std::cout << "Pond mesh created (" << meshCache.size() << " cached meshes)\n";
+
+    buildPropTransforms();
+    propInstances.create(cubeMesh.mesh);
+    std::cout << "Prop transforms cached: " << transforms.size() << " cube instances\n";
+
+    buildObjectBounds();
+    buildLights();
+    placeHeadlights();
+    std::cout << "Lights: " << sceneLights.size() << " (clustered)\n";
+    std::cout << "Object bounds computed for " << objectBounds.size() << " objects\n";
+    buildObjectBVH();
+    std::cout << "Object BVH built: " << objectBVH.nodeCount() << " nodes\n";
+    bakeLightmap();
+    if (shadows.create()) std::cout << "Shadow maps: " << ShadowCascades::kCascades << " cascades of " << ShadowCascades::kResolution << "^2\n";
+    shadows.setLight(kTowardsMoon, shadowBounds());
     
     // Initialize water animation
     waterTime = 0.0f;
-    ripplePhase = 0.0f;
     
     // Load realistic textures
     std::cout << "Loading textures...\n";
@@ -123,6 +221,12 @@ void CityScene::markGridCells(int x, int z, int size) {
 }
 
 void CityScene::generateFuturisticLayout() {
+    // Spatial index over the grid; objects are added as their bounds become known
+    auto gridOrigin = cellToWorld(0, 0);
+    spatialGrid.init(gridSize, kTileCells, gridOrigin.first - 0.5f, gridOrigin.second - 0.5f);
+
+    objects.clear();
+
     // Generate main roads in cross pattern
     int center = gridSize / 2;
     
@@ -148,8 +252,8 @@ void CityScene::generateFuturisticLayout() {
     // Place street lamps along roads
     placeStreetLamps();
     
-    // Place a car on the road
-    placeRandomCar();
+    // Cars driving the roads
+    placeTraffic();
     
     // City park pond with custom radius
     pond_cx = center + 8; pond_cy = center - 8; pond_r = (int)config.pondRadius;
@@ -171,10 +275,6 @@ void CityScene::generateFuturisticLayout() {
 }
 
 void CityScene::placeBuildingsRandomly() {
-    buildingCells.clear();
-    buildingHeights.clear();
-    buildingTypes.clear();
-    
     srand(12345); // Fixed seed to prevent shivering
     int center = gridSize / 2;
     
@@ -194,7 +294,6 @@ void CityScene::placeBuildingsRandomly() {
         }
         
         if (validPos) {
-            buildingCells.push_back({x, z});
             markGridCells(x, z, 5); // Mark 5x5 area
             
             // Determine building type based on style and counts
@@ -206,9 +305,9 @@ void CityScene::placeBuildingsRandomly() {
             } else {
                 // Mixed - use specific counts
                 int skyscrapersPlaced = 0, towersPlaced = 0, buildingsPlaced = 0;
-                for (int j = 0; j < (int)buildingTypes.size(); j++) {
-                    if (buildingTypes[j] == 0) skyscrapersPlaced++;
-                    else if (buildingTypes[j] == 1) towersPlaced++;
+                for (uint8_t placed : objects.table(OBJECT_BUILDING).type) {
+                    if (placed == 0) skyscrapersPlaced++;
+                    else if (placed == 1) towersPlaced++;
                     else buildingsPlaced++;
                 }
                 
@@ -217,8 +316,12 @@ void CityScene::placeBuildingsRandomly() {
                 else type = 2;
             }
             
-            buildingTypes.push_back(type);
-            buildingHeights.push_back(getFuturisticHeight(type, i));
+            // footprint as generated; replaced by the mesh bounds once the geometry exists
+            auto w = cellToWorld(x, z);
+            float width = (type == 0) ? config.skyscraperWidth : (type == 1) ? config.towerWidth : config.buildingWidth;
+            objects.add(OBJECT_BUILDING, glm::vec3(w.first, 0.0f, w.second),
+                        glm::vec3(width * 0.5f, getFuturisticHeight(type, i), width * 0.45f), // depth = 0.9 width
+                        (uint8_t)type, (uint8_t)type); // material: one texture per type
         }
     }
 }
@@ -233,7 +336,6 @@ float CityScene::getFuturisticHeight(int type, int index) {
 }
 
 void CityScene::placeTrees() {
-    treeCells.clear();
     srand(54321); // Fixed seed for trees to prevent shivering
     
     int numTrees = config.citySize * 8; // More trees for larger cities
@@ -254,49 +356,312 @@ void CityScene::placeTrees() {
         }
         
         if (validPos) {
-            treeCells.push_back({x, z});
+            auto w = cellToWorld(x, z);
+            objects.add(OBJECT_TREE, glm::vec3(w.first, 0.0f, w.second), glm::vec3(0.75f, 3.25f, 0.75f)); // trunk + foliage
             markGridCells(x, z, 3);
         }
     }
 }
 
 void CityScene::placeStreetLamps() {
-    streetLamps.clear();
     int center = gridSize / 2;
+    auto addLamp = [this](int x, int z) {
+        auto w = cellToWorld(x, z);
+        objects.add(OBJECT_LAMP, glm::vec3(w.first, 0.0f, w.second), glm::vec3(0.15f, 5.3f, 0.15f)); // pole + head
+        markGridCells(x, z);
+    };
     
     // Place lamps along horizontal road (avoid intersections)
     for (int i = 8; i < gridSize - 8; i += 6) {
         if (abs(i - center) > 3) {
-            if (center + 2 < gridSize && isGridCellFree(i, center + 2)) {
-                streetLamps.push_back({i, center + 2});
-                markGridCells(i, center + 2);
-            }
-            if (center - 2 >= 0 && isGridCellFree(i, center - 2)) {
-                streetLamps.push_back({i, center - 2});
-                markGridCells(i, center - 2);
-            }
+            if (center + 2 < gridSize && isGridCellFree(i, center + 2)) addLamp(i, center + 2);
+            if (center - 2 >= 0 && isGridCellFree(i, center - 2)) addLamp(i, center - 2);
         }
     }
     
     // Place lamps along vertical road (avoid intersections)
     for (int j = 8; j < gridSize - 8; j += 6) {
         if (abs(j - center) > 3) {
-            if (center + 2 < gridSize && isGridCellFree(center + 2, j)) {
-                streetLamps.push_back({center + 2, j});
-                markGridCells(center + 2, j);
-            }
-            if (center - 2 >= 0 && isGridCellFree(center - 2, j)) {
-                streetLamps.push_back({center - 2, j});
-                markGridCells(center - 2, j);
-            }
+            if (center + 2 < gridSize && isGridCellFree(center + 2, j)) addLamp(center + 2, j);
+            if (center - 2 >= 0 && isGridCellFree(center - 2, j)) addLamp(center - 2, j);
         }
     }
 }
 
-void CityScene::placeRandomCar() {
-    int center = gridSize / 2;
-    // Place car on horizontal road
-    carPosition = {center - 5, center};
+void CityScene::placeTraffic() {
+    auto origin = cellToWorld(0, 0);
+    roadGraph.build(roadCells, origin.first, origin.second);
+    std::cout << "Road graph: " << roadGraph.nodes().size() << " nodes (" << roadGraph.intersectionCount()
+              << " intersections, " << roadGraph.deadEndCount() << " dead ends), " << roadGraph.edges().size() << " edges\n";
+    laneGraph.build(roadGraph);
+    size_t wanted = (size_t)(laneGraph.totalLength() / kTrafficSpacing);
+    traffic.spawn(laneGraph, wanted, kTrafficSeed);
+    trafficCars.clear();
+    for (size_t i = 0; i < traffic.size(); i++) {
+        // body, roof and headlights fit in its extents
+        ObjectHandle car = objects.add(OBJECT_CAR, glm::vec3(traffic.x[i], 0.0f, traffic.z[i]), glm::vec3(1.15f, 1.2f, 0.5f), 0, 0, 0);
+        objects.setHeading(car, traffic.heading[i]);
+        trafficCars.push_back(car);
+    }
+    std::cout << "Traffic: " << traffic.size() << " cars on " << laneGraph.lanes().size() << " lanes\n";
+}
+
+void CityScene::buildBuildingGeometry() {
+    const ObjectStore::Table& placed = objects.table(OBJECT_BUILDING);
+    size_t n = placed.size();
+    std::vector<std::vector<MeshData>> chains(n);
+    std::vector<float> baseTops(n);
+
+    // generate, build the LOD chain and optimize every level on the worker pool
+    WorkerPool::shared().parallelFor(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            BuildingParams p;
+            p.x = placed.x[i];
+            p.z = placed.z[i];
+            p.width = placed.ex[i] * 2.0f;
+            p.depth = placed.ez[i] * 2.0f;
+            p.height = placed.ey[i];
+            p.type = placed.type[i];
+            p.seed = (unsigned int)i + 1;
+            chains[i] = buildLodChain(makeBuildingData(p), p.height); // box LOD: roof line, no spire/units
+            baseTops[i] = buildingBaseTop(p);
+            for (auto& level : chains[i]) optimizeMesh(level);
+        }
+    });
+
+    // reserve ranges serially (cheap), then copy into the arena in parallel
+    buildingArena.clear();
+    buildingLods.assign(n, BuildingLod());
+    size_t levelTris[kMaxLods] = {0, 0, 0, 0};
+    for (size_t i = 0; i < n; i++) {
+        BuildingLod& lod = buildingLods[i];
+        lod.count = std::min((int)chains[i].size(), kMaxLods);
+        for (int l = 0; l < lod.count; l++) {
+            lod.levels[l] = buildingArena.reserve(chains[i][l].vertexCount(), chains[i][l].idx.size());
+            levelTris[l] += chains[i][l].triangleCount();
+        }
+        // bounding sphere of the full-detail mesh
+        const MeshData& m = chains[i][0];
+        glm::vec3 lo(1e30f), hi(-1e30f);
+        for (size_t v = 0; v < m.vertexCount(); v++) {
+            glm::vec3 p(m.verts[v*8], m.verts[v*8+1], m.verts[v*8+2]);
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+        }
+        lod.bounds.min = lo;
+        lod.bounds.max = hi;
+        // the base tier spans the whole footprint, so only its height differs from the bounds
+        lod.occluder.min = lo;
+        lod.occluder.max = glm::vec3(hi.x, baseTops[i], hi.z);
+        lod.center = (lo + hi) * 0.5f;
+        lod.radius = glm::length(hi - lo) * 0.5f;
+        lod.footprintRadius = glm::length(glm::vec2(hi.x - lo.x, hi.z - lo.z)) * 0.5f;
+        lod.halfExtent = std::max(lod.footprintRadius, (hi.y - lo.y) * 0.5f);
+    }
+
+    // impostor classes: one atlas row per (type, 5-unit height bucket, setback bucket). The
+    // seed moves the first setback, which shapes the silhouette most, so its height is part
+    // of the key in 5% steps; upper tier widths and roof details come from the class's first building
+    std::map<std::tuple<int,int,int>, int> classOf;
+    impostorClassReps.clear();
+    for (size_t i = 0; i < n; i++) {
+        std::tuple<int,int,int> key(placed.type[i], (int)std::round(placed.ey[i] / 5.0f),
+                                    (int)std::round(baseTops[i] / std::max(placed.ey[i], 0.001f) * 20.0f));
+        auto it = classOf.find(key);
+        if (it == classOf.end()) {
+            it = classOf.emplace(key, (int)impostorClassReps.size()).first;
+            impostorClassReps.push_back(i);
+        }
+        buildingLods[i].impostorClass = it->second;
+    }
+    // from here on the store holds the generated geometry's bounds
+    for (size_t i = 0; i < n; i++) objects.setBounds(objects.handle(OBJECT_BUILDING, i), buildingLods[i].bounds);
+    // building i gets lightmap facade chart i (buildings are the first occluders baked)
+    WorkerPool::shared().parallelFor(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            for (int l = 0; l < buildingLods[i].count; l++)
+                buildingArena.write(buildingLods[i].levels[l], chains[i][l], (int)i + 1);
+    });
+    buildingArena.upload();
+
+    std::cout << "Building LOD triangles:";
+    for (int l = 0; l < kMaxLods; l++) std::cout << " L" << l << "=" << levelTris[l];
+    std::cout << "\n";
+}
+
+size_t CityScene::addObjectBounds(const AABB& box) {
+    size_t id = objectBounds.add(box);
+    spatialGrid.insert((uint32_t)id, box);
+    return id;
+}
+
+void CityScene::setObjectBounds(size_t id, const AABB& box) {
+    objectBounds.set(id, box);
+    spatialGrid.update((uint32_t)id, box); // incremental: only re-buckets on tile change
+    if (id < pondBoundsIndex) bvhDirty = true;
+}
+
+void CityScene::buildObjectBVH() {
+    // pond and roads cover the whole ground plane, so they are left out of ray queries
+    std::vector<AABB> boxes(pondBoundsIndex);
+    for (size_t i = 0; i < boxes.size(); i++) boxes[i] = objectBounds.get(i);
+    objectBVH.build(boxes, &WorkerPool::shared());
+    bvhDirty = false;
+}
+
+const BVH& CityScene::objectQueries() {
+    if (bvhDirty) {
+        std::vector<AABB> boxes(pondBoundsIndex);
+        for (size_t i = 0; i < boxes.size(); i++) boxes[i] = objectBounds.get(i);
+        objectBVH.refit(boxes);
+        bvhDirty = false;
+    }
+    return objectBVH;
+}
+
+glm::mat4 CityScene::projection(float aspect) const {
+    return glm::perspective(kFovY, aspect, kNearPlane, kFarPlane);
+}
+
+int CityScene::pick(const Camera& cam, float ndcX, float ndcY, float aspect) {
+    glm::mat4 inv = glm::inverse(projection(aspect) * cam.viewMatrix());
+    glm::vec4 nearP = inv * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farP = inv * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearP) / nearP.w;
+    glm::vec3 dir = glm::vec3(farP) / farP.w - origin;
+
+    BVH::Hit hit;
+    selectedObject = objectQueries().raycast(origin, dir, glm::length(dir), hit) ? hit.id : -1;
+    if (selectedObject < 0) {
+        std::cout << "Picked: nothing\n";
+        return selectedObject;
+    }
+    ObjectKind kind = objects.kindOfId(selectedObject);
+    size_t row = selectedObject - objects.firstId(kind);
+    if (kind == OBJECT_BUILDING) {
+        static const char* typeNames[3] = {"skyscraper", "tower", "office"};
+        const ObjectStore::Table& t = objects.table(OBJECT_BUILDING);
+        std::cout << "Picked: building " << row << " (" << typeNames[std::min<int>(t.type[row], 2)]
+                  << ", height " << t.ey[row] << ") at distance " << hit.t << "\n";
+    } else if (kind == OBJECT_TREE) {
+        std::cout << "Picked: tree " << row << "\n";
+    } else if (kind == OBJECT_LAMP) {
+        std::cout << "Picked: street lamp " << row << "\n";
+    } else {
+        std::cout << "Picked: car " << row << "\n";
+    }
+    return selectedObject;
+}
+
+bool CityScene::lineOfSight(const glm::vec3& a, const glm::vec3& b) {
+    return !objectQueries().occluded(a, b);
+}
+
+void CityScene::buildObjectBounds() {
+    objectBounds.clear();
+    spatialGrid.clear();
+    auto box = [](float x, float z, float hx, float y0, float y1, float hz) {
+        AABB b;
+        b.min = glm::vec3(x - hx, y0, z - hz);
+        b.max = glm::vec3(x + hx, y1, z + hz);
+        return b;
+    };
+
+    // bounds IDs are the store's dense IDs
+    for (int k = 0; k < OBJECT_KIND_COUNT; k++) {
+        const ObjectStore::Table& t = objects.table((ObjectKind)k);
+        for (size_t row = 0; row < t.size(); row++) addObjectBounds(t.bounds(row));
+    }
+    auto pondW = cellToWorld(pond_cx, pond_cy);
+    pondBoundsIndex = addObjectBounds(box(pondW.first, pondW.second, (float)pond_r, 0.0f, kWaterLevel + 0.05f, (float)pond_r));
+    float half = gridSize * 0.5f;
+    roadBoundsIndex = addObjectBounds(box(0.0f, 0.0f, half, 0.0f, 0.03f, half));
+}
+
+void CityScene::cullObjects(const glm::mat4& viewProj) {
+    Frustum frustum = Frustum::fromMatrix(viewProj);
+
+    // XZ footprint of the frustum from its 8 corners, to limit the tiles visited
+    glm::mat4 inv = glm::inverse(viewProj);
+    float minX = 1e30f, minZ = 1e30f, maxX = -1e30f, maxZ = -1e30f;
+    for (int c = 0; c < 8; c++) {
+        glm::vec4 p = inv * glm::vec4((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f, 1.0f);
+        p /= p.w;
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minZ = std::min(minZ, p.z); maxZ = std::max(maxZ, p.z);
+    }
+
+    // whole tiles inside the frustum are accepted; objects in boundary tiles get the SIMD box test
+    tileInside.clear();
+    tilePartial.clear();
+    spatialGrid.queryFrustum(frustum, minX, minZ, maxX, maxZ, tileInside, tilePartial);
+    objectVisible.assign(objectBounds.size(), 0);
+    for (uint32_t id : tileInside) objectVisible[id] = 1;
+    partialBounds.clear();
+    for (uint32_t id : tilePartial) partialBounds.add(objectBounds.get(id));
+    cullAABBs(frustum, partialBounds, partialVisible);
+    for (size_t i = 0; i < tilePartial.size(); i++) objectVisible[tilePartial[i]] = partialVisible[i];
+}
+
+void CityScene::occludeObjects(const glm::mat4& viewProj, const glm::vec3& eye, float aspect) {
+    // Two-phase scheme on the CPU: the buildings that were visible last frame act as
+    // occluders (phase 1), then every frustum-visible object is tested against their
+    // Hi-Z pyramid (phase 2). Because the depth comes from this frame's camera, objects
+    // visible last frame are re-tested too instead of being drawn unconditionally.
+    size_t buildings = buildingLods.size();
+    bool haveHistory = lastVisible.size() == objectBounds.size();
+    occluderOrder.clear();
+    for (size_t i = 0; i < buildings; i++) {
+        if (!objectVisible[i] || (haveHistory && !lastVisible[i])) continue;
+        const BuildingLod& lod = buildingLods[i];
+        float dist = std::max(glm::length(lod.center - eye), 0.1f);
+        float size = lod.radius / dist;
+        if (size >= kMinOccluderSize) occluderOrder.push_back(std::make_pair(size, (uint32_t)i));
+    }
+    std::sort(occluderOrder.begin(), occluderOrder.end(),
+              [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
+    if (occluderOrder.size() > (size_t)kMaxOccluders) occluderOrder.resize(kMaxOccluders);
+
+    occlusionBuffer.begin(viewProj, eye, kOcclusionWidth, (int)(kOcclusionWidth / std::max(aspect, 0.1f)));
+    for (auto& o : occluderOrder) occlusionBuffer.addOccluder(buildingLods[o.second].occluder);
+    occlusionBuffer.buildHiZ();
+
+    // pond and roads lie under everything, so only buildings and props are tested
+    for (size_t id = 0; id < pondBoundsIndex; id++) {
+        if (!objectVisible[id] || occlusionBuffer.visible(objectBounds.get(id))) continue;
+        objectVisible[id] = 0;
+        renderStats.occludedObjects++;
+    }
+    lastVisible = objectVisible;
+}
+
+void CityScene::buildImpostors(ShaderVariants& shaders) {
+    impostorsBuilt = true;
+    if (impostorClassReps.empty() || !impostorAtlas.create((int)impostorClassReps.size())) return;
+    glActiveTexture(GL_TEXTURE0);
+    for (size_t c = 0; c < impostorClassReps.size(); c++) {
+        size_t rep = impostorClassReps[c];
+        const BuildingLod& lod = buildingLods[rep];
+        GLuint tex = buildingTexture(objects.table(OBJECT_BUILDING).material[rep]);
+        const Shader& shader = shaders.get(tex ? kBuildingShader : SHADER_UNIFORM_SCALE);
+        shader.use();
+        shader.setModel(glm::mat4(1.0f));
+        shader.setVec3("baseColor", glm::vec3(1.0f, 1.0f, 1.0f));
+        if (tex) shader.setInt("tex", 0);
+        lightClusters.bind(shader, 1, false); // lamp-independent views
+        shadows.bind(shader, 10, false);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        std::vector<ArenaRange> full(1, lod.levels[0]);
+        impostorAtlas.renderClass((int)c, shader, lod.center, lod.halfExtent, [&] { buildingArena.draw(full); });
+    }
+    impostorAtlas.finish();
+    std::cout << "Impostor atlas built: " << impostorClassReps.size() << " classes x " << ImpostorAtlas::kViews << " views\n";
+}
+
+GLuint CityScene::buildingTexture(int type) const {
+    if (type == 0) return skyscraperTex; // Skyscrapers
+    if (type == 1) return towerTex;      // Towers
+    return buildingTex;                  // Office buildings
 }
 
 glm::vec3 CityScene::getFuturisticColor(int type) {
@@ -309,171 +674,403 @@ glm::vec3 CityScene::getFuturisticColor(int type) {
 }
 
 void CityScene::update(float dt) {
-    // Animate water effects
+    // the only per-frame water state: the shaders derive the waves from it
     waterTime += dt * 2.0f; // Water animation speed
-    ripplePhase += dt * 3.0f; // Ripple animation speed
+
+    // traffic step on the worker pool, then the cars' roots follow (parts via the hierarchy)
+    traffic.step(std::min(dt, 0.1f), &WorkerPool::shared());
+    for (size_t i = 0; i < trafficCars.size(); i++)
+        moveObject(trafficCars[i], glm::vec3(traffic.x[i], 0.0f, traffic.z[i]), traffic.heading[i]);
+    transforms.update();
+    placeHeadlights();
 }
 
-void CityScene::render(const Shader& shader, const Camera& cam) {
-    shader.use();
-    shader.setMat4("view", cam.viewMatrix());
-    
+std::vector<unsigned> CityScene::shaderVariants(RenderPath path) {
+    std::vector<unsigned> materials = { kPropShader, kGroundShader, kStaticShader, kStaticUntexturedShader,
+                                        kWaterShader, kWaterShader | SHADER_TEXTURED, kEmissiveShader,
+                                        kEmissivePropShader };
+    if (path == RENDER_FORWARD) {
+        // impostors are captured with the unlightmapped building variants
+        materials.push_back(kBuildingShader);
+        materials.push_back(SHADER_UNIFORM_SCALE);
+        materials.push_back(kShadowShader);
+        materials.push_back(kPropShadowShader);
+        return materials;
+    }
+    // impostors are still captured with the forward building variants
+    std::vector<unsigned> out = { SHADER_UNIFORM_SCALE, kBuildingShader, SHADER_LIGHT_PASS, kShadowShader, kPropShadowShader };
+    for (unsigned m : materials) out.push_back(m | SHADER_GBUFFER);
+    return out;
+}
+
+const Shader& CityScene::bindShader(ShaderVariants& shaders, unsigned features) const {
+    features |= framePass;
+    const Shader& s = shaders.get(features);
+    s.use();
+    s.setMat4("view", frameView);
+    s.setMat4("proj", frameProj);
+    s.setVec3("viewPos", frameEye);
+    if (features & SHADER_TEXTURED) s.setInt("tex", 0);
+    if (!(features & (SHADER_EMISSIVE | SHADER_GBUFFER))) {
+        lightClusters.bind(s, 1);
+        shadows.bind(s, 10); // also sets the moon direction
+    }
+    if (features & SHADER_LIGHTMAPPED) lightmap.bind(s, 8);
+    return s;
+}
+
+void CityScene::lightGBuffer(ShaderVariants& shaders) {
+    // every lit pixel once, lamps looked up from its cluster; gl_FragDepth carries the
+    // scene depth over so the impostors drawn afterwards are still depth tested against it
+    const Shader& s = bindShader(shaders, SHADER_LIGHT_PASS);
+    s.setMat4("invViewProj", glm::inverse(frameProj * frameView));
+    gbuffer.bindTextures(s, 4); // after the cluster buffers on 1..3
+    glDepthFunc(GL_ALWAYS);
+    gbuffer.drawFullscreen();
+    glDepthFunc(GL_LESS);
+}
+
+void CityScene::buildLights() {
+    sceneLights.clear();
+    const ObjectStore::Table& lamps = objects.table(OBJECT_LAMP);
+    for (size_t i = 0; i < lamps.size(); i++) {
+        PointLight l;
+        l.position = glm::vec3(lamps.x[i], 5.0f, lamps.z[i]); // just under the lamp head
+        l.radius = 9.0f;
+        l.color = glm::vec3(1.0f, 0.85f, 0.6f); // Warm street light
+        l.intensity = 8.0f;
+        l.baked = true;
+        sceneLights.push_back(l);
+    }
+    headlightStart = sceneLights.size();
+    for (size_t i = 0; i < objects.count(OBJECT_CAR) * 2; i++) {
+        PointLight l;
+        l.radius = 5.0f;
+        l.color = glm::vec3(1.0f, 1.0f, 0.9f); // headlight
+        l.intensity = 3.0f;
+        sceneLights.push_back(l);
+    }
+}
+
+void CityScene::placeHeadlights() {
+    // just ahead of the headlight parts, in each car's frame
+    for (size_t i = 0; i < objects.count(OBJECT_CAR); i++) {
+        const glm::mat4& car = transforms.world(rootTransforms[OBJECT_CAR] + (uint32_t)i);
+        sceneLights[headlightStart + 2 * i].position = glm::vec3(car * glm::vec4(1.3f, 0.5f, 0.3f, 1.0f));
+        sceneLights[headlightStart + 2 * i + 1].position = glm::vec3(car * glm::vec4(1.3f, 0.5f, -0.3f, 1.0f));
+    }
+}
+
+void CityScene::bakeLightmap() {
+    // static occluders: buildings (first, one chart each), trees and lamp posts; cars move, so they're left out
+    LightmapInputs in;
+    std::vector<int> lampOccluder(objects.count(OBJECT_LAMP), -1);
+    for (int k = 0; k < OBJECT_KIND_COUNT; k++) {
+        const ObjectStore::Table& t = objects.table((ObjectKind)k);
+        for (size_t row = 0; row < t.size(); row++) {
+            if (!(t.flags[row] & OBJECT_STATIC)) continue;
+            if (k == OBJECT_LAMP) lampOccluder[row] = (int)in.occluders.size();
+            in.occluders.push_back(t.bounds(row));
+        }
+    }
+    in.buildingCount = buildingLods.size();
+    for (size_t l = 0; l < lampOccluder.size(); l++) {
+        if (lampOccluder[l] < 0) continue;
+        in.lights.push_back(sceneLights[l]); // lamps come first in sceneLights
+        in.lightOwners.push_back(lampOccluder[l]);
+    }
+    float half = gridSize * 0.5f;
+    in.groundMin = glm::vec2(-half, -half);
+    in.groundMax = glm::vec2(half, half);
+
+    uint64_t key = Lightmap::layoutKey(in);
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.lmap", (unsigned long long)key);
+    std::string path = std::string(kLightmapCacheDir) + name;
+    if (lightmap.load(path, key)) {
+        std::cout << "Lightmap loaded from " << path << "\n";
+    } else {
+        std::cout << "Baking lightmap...\n";
+        auto t0 = std::chrono::steady_clock::now();
+        lightmap.bake(in);
+        std::cout << "Lightmap baked in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count()
+                  << " ms\n";
+        std::error_code ec;
+        std::filesystem::create_directories(kLightmapCacheDir, ec);
+        if (ec || !lightmap.save(path, key)) std::cerr << "Could not write lightmap cache " << path << "\n";
+    }
+    lightmap.upload();
+    std::cout << "Lightmap: " << lightmap.width() << "x" << lightmap.height() << " atlas\n";
+}
+
+void CityScene::drawCube(const Shader& shader, const glm::mat4& model, const glm::vec3& color) const {
+    shader.setModel(model);
+    shader.setVec3("baseColor", color);
+    glBindVertexArray(cubeMesh.mesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.mesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
+}
+
+void CityScene::buildPropTransforms() {
+    // computed once here; afterwards only moved objects touch their roots
+    transforms.clear();
+    bool hasParts[OBJECT_KIND_COUNT] = {};
+    for (auto& part : kPropParts) hasParts[part.kind] = true;
+    for (int k = 0; k < OBJECT_KIND_COUNT; k++) {
+        rootTransforms[k] = (uint32_t)transforms.size();
+        if (!hasParts[k]) continue;
+        for (size_t row = 0; row < objects.count((ObjectKind)k); row++) transforms.add(objectTransform((ObjectKind)k, row));
+    }
+    partTransforms.resize(kPropPartCount);
+    for (size_t p = 0; p < kPropPartCount; p++) {
+        ObjectKind kind = kPropParts[p].kind;
+        partTransforms[p] = (uint32_t)transforms.size();
+        for (size_t row = 0; row < objects.count(kind); row++)
+            transforms.add(partMatrix(kPropParts[p]), rootTransforms[kind] + (uint32_t)row);
+    }
+    transforms.update();
+}
+
+glm::mat4 CityScene::objectTransform(ObjectKind kind, size_t row) const {
+    const ObjectStore::Table& t = objects.table(kind);
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), t.position(row));
+    return t.heading[row] != 0.0f ? glm::rotate(m, t.heading[row], glm::vec3(0.0f, 1.0f, 0.0f)) : m;
+}
+
+void CityScene::moveObject(ObjectHandle h, const glm::vec3& position, float heading) {
+    if (!objects.valid(h)) return;
+    objects.setPosition(h, position);
+    objects.setHeading(h, heading);
+    ObjectKind kind = objects.kind(h);
+    size_t row = objects.row(h);
+    // the parts follow their root on the next transforms.update()
+    transforms.setLocal(rootTransforms[kind] + (uint32_t)row, objectTransform(kind, row));
+    setObjectBounds(objects.id(kind, row), objects.table(kind).bounds(row));
+}
+
+void CityScene::drawProps(const Shader& props, const std::vector<uint8_t>& visible, bool emissive, bool staticOnly) const {
+    // every part is one block of instances, drawn as runs of consecutive visible rows
+    for (size_t p = 0; p < kPropPartCount; p++) {
+        const PropPart& part = kPropParts[p];
+        if (part.emissive != emissive) continue;
+        const ObjectStore::Table& t = objects.table(part.kind);
+        const uint8_t* rowVisible = &visible[objects.firstId(part.kind)];
+        auto drawn = [&](size_t row) { return rowVisible[row] && (!staticOnly || (t.flags[row] & OBJECT_STATIC)); };
+        props.setVec3("baseColor", part.color);
+        for (size_t row = 0; row < t.size();) {
+            if (!drawn(row)) { row++; continue; }
+            size_t end = row + 1;
+            while (end < t.size() && drawn(end)) end++;
+            propInstances.draw(partTransforms[p] + row, end - row);
+            row = end;
+        }
+    }
+}
+
+AABB CityScene::shadowBounds() const {
+    // every caster and receiver: the ground square plus everything standing on it
+    float half = gridSize * 0.5f;
+    AABB b;
+    b.min = glm::vec3(-half, -0.5f, -half);
+    b.max = glm::vec3(half, 0.0f, half);
+    for (size_t i = 0; i < pondBoundsIndex; i++) {
+        AABB o = objectBounds.get(i);
+        b.min = glm::min(b.min, o.min);
+        b.max = glm::max(b.max, o.max);
+    }
+    return b;
+}
+
+void CityScene::renderShadows(ShaderVariants& shaders, float aspect) {
+    if (!shadows.ready()) return;
+    shadows.fit(frameView, kFovY, aspect, kNearPlane);
+    const Shader& propDepth = shaders.get(kPropShadowShader);
+    propDepth.use();
+    propDepth.setMat4("view", shadows.view());
+    const Shader& depth = shaders.get(kShadowShader);
+    depth.use();
+    depth.setMat4("view", shadows.view());
+    for (int c = 0; c < ShadowCascades::kCascades; c++) {
+        // the city cascade only holds static casters, so it is redrawn only when stale
+        bool cached = c == ShadowCascades::kCascades - 1;
+        if (cached && !shadows.cachedDirty()) continue;
+        shadows.beginCascade(c);
+        depth.use();
+        depth.setMat4("proj", shadows.projection(c));
+        depth.setModel(glm::mat4(1.0f)); // building geometry is in world space
+        cullAABBs(Frustum::fromMatrix(shadows.lightViewProj(c)), objectBounds, shadowVisible);
+        // a coarse LOD is plenty for shadow silhouettes; the far cascade takes the coarsest
+        shadowRanges.clear();
+        for (size_t i = 0; i < buildingLods.size(); i++) {
+            if (!shadowVisible[i]) continue;
+            const BuildingLod& lod = buildingLods[i];
+            shadowRanges.push_back(lod.levels[cached ? lod.count - 1 : std::min(kShadowLod, lod.count - 1)]);
+        }
+        buildingArena.draw(shadowRanges);
+        propDepth.use();
+        propDepth.setMat4("proj", shadows.projection(c));
+        drawProps(propDepth, shadowVisible, false, cached);
+        renderStats.shadowCascadesDrawn++;
+    }
+    shadows.end();
+}
+
+void CityScene::render(ShaderVariants& shaders, const Camera& cam) {
+    if (!impostorsBuilt) buildImpostors(shaders); // needs a GL context + the scene shaders, so done lazily
+
     int viewport[4];
     glGetIntegerv(GL_VIEWPORT, viewport);
     float aspect = (float)viewport[2] / (float)viewport[3];
-    glm::mat4 proj = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 200.0f);
-    shader.setMat4("proj", proj);
-    shader.setVec3("lightPos", glm::vec3(0.0f, 8.0f, 0.0f)); // Lower night lighting
-    shader.setVec3("viewPos", cam.position());
+    glm::mat4 proj = projection(aspect);
+    frameView = cam.viewMatrix();
+    frameProj = proj;
+    frameEye = cam.position();
 
+    // prop matrices are only recomputed and sent to the GPU when something moved
+    transforms.update();
+    if (transforms.dirty()) {
+        propInstances.upload(transforms.data(), transforms.size(), transforms.dirtyBegin(), transforms.dirtyEnd());
+        transforms.clearDirty();
+    }
+
+    // bin every lamp into the view's clusters (parallel), shared by all lit variants
+    lightClusters.build(sceneLights, frameView, proj, kNearPlane, kFarPlane);
+    lightClusters.upload();
+
+    // frustum culling: visible tiles from the spatial grid, then per-object SIMD box tests
+    renderStats = RenderStats();
+    cullObjects(proj * cam.viewMatrix());
+    for (uint8_t v : objectVisible) {
+        if (v) renderStats.visibleObjects++;
+        else renderStats.culledObjects++;
+    }
+    // then drop what tall buildings hide, using a CPU-rasterized depth pyramid
+    if (occlusionCulling) {
+        occludeObjects(proj * cam.viewMatrix(), cam.position(), aspect);
+        renderStats.visibleObjects -= renderStats.occludedObjects;
+    }
+
+    // moon shadows: the camera cascades, plus the cached city cascade if it went stale
+    renderShadows(shaders, aspect);
+
+    // deferred: the same passes below fill the G-buffer instead, lit afterwards in one pass
+    bool deferred = false;
+    if (renderPath == RENDER_DEFERRED) {
+        deferred = gbuffer.resize(viewport[2], viewport[3]);
+        if (!deferred) {
+            std::cerr << "Deferred shading unavailable, falling back to forward\n";
+            renderPath = RENDER_FORWARD;
+        }
+    }
+    framePass = deferred ? SHADER_GBUFFER : 0;
+    if (deferred) gbuffer.beginGeometry();
+
+    // Draws are grouped by shader variant: lightmapped ground, lit props, lightmapped
+    // world-space geometry, water, then emissive lights, so each variant is bound once per frame.
 
     // dark night ground
+    const Shader& ground = bindShader(shaders, kGroundShader);
     glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.501f, 0.0f));
     model = glm::scale(model, glm::vec3((float)gridSize, 1.0f, (float)gridSize));
-    shader.setMat4("model", model);
-    shader.setVec3("baseColor", glm::vec3(0.1f, 0.15f, 0.1f)); // Dark grass at night
-    shader.setFloat("useTexture", 0.0f);
-    glBindVertexArray(cubeMesh.vao);
-    glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    // realistic asphalt roads
+    drawCube(ground, model, glm::vec3(0.1f, 0.15f, 0.1f)); // Dark grass at night
+
+    // lit, untextured props
+    const Shader& props = bindShader(shaders, kPropShader);
+
+    drawProps(props, objectVisible, false, false);
+
+    // realistic asphalt roads (merged strips, single draw); world-space, so no normal matrix
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, roadTex);
-    int center = gridSize / 2;
-    for (auto &c : roadCells) {
-        auto w = cellToWorld(c.first, c.second);
-        glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(w.first, 0.02f, w.second));
-        
-        // Rotate texture for vertical roads to align dotted lines
-        if (c.first == center) { // Vertical road
-            m = glm::rotate(m, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        }
-        
-        m = glm::scale(m, glm::vec3(1.0f,1.0f,1.0f));
-        shader.setMat4("model", m);
-        shader.setVec3("baseColor", glm::vec3(0.2f, 0.2f, 0.2f)); // Dark asphalt
-        shader.setFloat("useTexture", roadTex ? 1.0f : 0.0f);
-        shader.setInt("tex", 0);
-        glBindVertexArray(quadMesh.vao);
-        glDrawElements(GL_TRIANGLES, quadMesh.elemCount, GL_UNSIGNED_INT, 0);
+    if (objectVisible[roadBoundsIndex]) {
+        const Shader& roads = bindShader(shaders, roadTex ? kStaticShader : kStaticUntexturedShader);
+        glBindTexture(GL_TEXTURE_2D, roadTex);
+        roads.setModel(glm::mat4(1.0f));
+        roads.setVec3("baseColor", glm::vec3(0.2f, 0.2f, 0.2f)); // Dark asphalt
+        glBindVertexArray(roadMesh.vao);
+        glDrawElements(GL_TRIANGLES, roadMesh.elemCount, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
     }
 
-    // Water pond with texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, pondTex);
-    glm::mat4 pondModel = glm::mat4(1.0f);
-    shader.setMat4("model", pondModel);
-    shader.setVec3("baseColor", glm::vec3(1.0f, 1.0f, 1.0f));
-    shader.setFloat("useTexture", pondTex ? 1.0f : 0.0f);
-    shader.setInt("tex", 0);
-    glBindVertexArray(pondMesh.vao);
-    glDrawElements(GL_TRIANGLES, pondMesh.elemCount, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-    
+    // realistic buildings: pick a LOD per building from its projected size, then
+    // draw each texture's ranges from the shared arena with one multi-draw
+    glm::vec3 eye = cam.position();
+    float tanHalfFov = tanf(kFovY * 0.5f);
+    for (auto& list : buildingsByType) list.clear();
+    for (auto& list : fadingByType) list.clear();
+    impostorBatch.begin();
+    for (size_t i = 0; i < buildingLods.size(); i++) {
+        if (!objectVisible[i]) continue; // buildings are the first table, so their IDs are their rows
+        BuildingLod& lod = buildingLods[i];
+        float dist = std::max(glm::length(lod.center - eye), 0.001f);
+        float projected = lod.radius / (dist * tanHalfFov); // sphere diameter / screen height
+        lod.current = selectLod(projected, lod.current, lod.count);
 
+        // far away: billboard only; in the fade band the billboard takes over a growing
+        // share of the pixels and the geometry drops the same share
+        int type = std::min<int>(objects.table(OBJECT_BUILDING).material[i], 2);
+        if (impostorAtlas.ready() && projected < kImpostorSize + kImpostorFade) {
+            float fade = std::min(1.0f, (kImpostorSize + kImpostorFade - projected) / kImpostorFade);
+            int view = ImpostorAtlas::viewIndex(eye - lod.center);
+            impostorBatch.add(lod.center, lod.halfExtent, lod.footprintRadius, eye,
+                              impostorAtlas.cellRect(lod.impostorClass, view), fade);
+            renderStats.impostors++;
+            if (projected >= kImpostorSize) fadingByType[type].push_back(std::make_pair(lod.levels[lod.current], fade));
+            continue;
+        }
+        buildingsByType[type].push_back(lod.levels[lod.current]);
+    }
+    for (int textured = 1; textured >= 0; textured--) {
+        const Shader* buildings = nullptr;
+        for (int type = 0; type < 3; type++) {
+            GLuint currentTex = buildingTexture(type);
+            if ((currentTex != 0) != (textured != 0)) continue;
+            if (buildingsByType[type].empty() && fadingByType[type].empty()) continue;
+            if (!buildings) {
+                buildings = &bindShader(shaders, textured ? kStaticShader : kStaticUntexturedShader);
+                buildings->setModel(glm::mat4(1.0f));
+                buildings->setVec3("baseColor", glm::vec3(1.0f, 1.0f, 1.0f)); // White to show texture colors
+            }
+            glBindTexture(GL_TEXTURE_2D, currentTex);
+            if (!buildingsByType[type].empty()) buildingArena.draw(buildingsByType[type]);
+            // the few buildings in the fade band, one draw each for their own dissolve
+            for (const auto& fading : fadingByType[type]) {
+                buildings->setFloat("dissolve", fading.second);
+                buildingArena.draw(std::vector<ArenaRange>(1, fading.first));
+            }
+            if (!fadingByType[type].empty()) buildings->setFloat("dissolve", 0.0f);
+        }
+    }
 
-    // realistic buildings with different textures per type
-    glActiveTexture(GL_TEXTURE0);
-    for (size_t i = 0; i < buildingCells.size(); i++) {
-        auto &bcell = buildingCells[i];
-        auto w = cellToWorld(bcell.first, bcell.second);
-        float height = buildingHeights[i];
-        int type = buildingTypes[i];
-        
-        // Bind appropriate texture based on building type
-        GLuint currentTex = 0;
-        if (type == 0) currentTex = skyscraperTex; // Skyscrapers
-        else if (type == 1) currentTex = towerTex; // Towers
-        else currentTex = buildingTex; // Office buildings
-        
-        glBindTexture(GL_TEXTURE_2D, currentTex);
-        
-        // Custom building proportions from user input
-        float width = (type == 0) ? config.skyscraperWidth : (type == 1) ? config.towerWidth : config.buildingWidth;
-        float depth = width * 0.9f; // Fixed ratio
-        
-        glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(w.first, height/2.0f, w.second));
-        m = glm::scale(m, glm::vec3(width, height, depth));
-        shader.setMat4("model", m);
-        shader.setVec3("baseColor", glm::vec3(1.0f, 1.0f, 1.0f)); // White to show texture colors
-        shader.setFloat("useTexture", currentTex ? 1.0f : 0.0f);
-        shader.setInt("tex", 0);
-        glBindVertexArray(cubeMesh.vao);
-        glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0);
+    // Water pond with texture
+    if (objectVisible[pondBoundsIndex]) {
+        const Shader& water = bindShader(shaders, pondTex ? (kWaterShader | SHADER_TEXTURED) : kWaterShader);
+        glBindTexture(GL_TEXTURE_2D, pondTex);
+        water.setModel(pondMesh.transform);
+        water.setVec3("baseColor", glm::vec3(0.1f, 0.25f, 0.4f)); // used when the texture is missing
+        water.setFloat("time", waterTime);
+        glBindVertexArray(pondMesh.mesh.vao);
+        glDrawElements(GL_TRIANGLES, pondMesh.mesh.elemCount, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
     }
 
+    // unlit lights: lamp heads and headlights
+    drawProps(bindShader(shaders, kEmissivePropShader), objectVisible, true, false);
 
+    // wireframe box around the picked object
+    if (selectedObject >= 0) {
+        const Shader& emissive = bindShader(shaders, kEmissiveShader);
+        AABB b = objectBounds.get(selectedObject);
+        glm::mat4 outline = glm::translate(glm::mat4(1.0f), (b.min + b.max) * 0.5f);
+        outline = glm::scale(outline, (b.max - b.min) * 1.02f);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        drawCube(emissive, outline, glm::vec3(1.0f, 0.8f, 0.1f));
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
 
-    // Realistic trees
-    shader.setFloat("useTexture", 0.0f);
-    for (auto &tree : treeCells) {
-        auto w = cellToWorld(tree.first, tree.second);
-        
-        // Tree trunk
-        glm::mat4 trunk = glm::translate(glm::mat4(1.0f), glm::vec3(w.first, 1.0f, w.second));
-        trunk = glm::scale(trunk, glm::vec3(0.3f, 2.0f, 0.3f));
-        shader.setMat4("model", trunk);
-        shader.setVec3("baseColor", glm::vec3(0.4f, 0.2f, 0.1f)); // Brown trunk
-        glBindVertexArray(cubeMesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
-        
-        // Tree foliage
-        glm::mat4 leaves = glm::translate(glm::mat4(1.0f), glm::vec3(w.first, 2.5f, w.second));
-        leaves = glm::scale(leaves, glm::vec3(1.5f, 1.5f, 1.5f));
-        shader.setMat4("model", leaves);
-        shader.setVec3("baseColor", glm::vec3(0.1f, 0.6f, 0.1f)); // Green leaves
-        glBindVertexArray(cubeMesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
-    }
-
-    // Street lamps with glowing lights
-    shader.setFloat("useTexture", 0.0f);
-    for (auto &lamp : streetLamps) {
-        auto w = cellToWorld(lamp.first, lamp.second);
-        
-        // Lamp pole
-        glm::mat4 pole = glm::translate(glm::mat4(1.0f), glm::vec3(w.first, 2.5f, w.second));
-        pole = glm::scale(pole, glm::vec3(0.1f, 5.0f, 0.1f));
-        shader.setMat4("model", pole);
-        shader.setVec3("baseColor", glm::vec3(0.2f, 0.2f, 0.2f)); // Dark metal
-        glBindVertexArray(cubeMesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
-        
-        // Glowing lamp head
-        glm::mat4 light = glm::translate(glm::mat4(1.0f), glm::vec3(w.first, 5.2f, w.second));
-        light = glm::scale(light, glm::vec3(0.3f, 0.2f, 0.3f));
-        shader.setMat4("model", light);
-        shader.setVec3("baseColor", glm::vec3(1.0f, 0.9f, 0.6f)); // Warm street light
-        glBindVertexArray(cubeMesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
+    if (deferred) {
+        gbuffer.end();
+        framePass = 0;
+        lightGBuffer(shaders);
     }
 
-    // Car on the road
-    auto carW = cellToWorld(carPosition.first, carPosition.second);
-    
-    // Car body
-    glm::mat4 carBody = glm::translate(glm::mat4(1.0f), glm::vec3(carW.first, 0.4f, carW.second));
-    carBody = glm::scale(carBody, glm::vec3(2.0f, 0.8f, 1.0f));
-    shader.setMat4("model", carBody);
-    shader.setVec3("baseColor", glm::vec3(0.8f, 0.1f, 0.1f)); // Red car
-    glBindVertexArray(cubeMesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
-    
-    // Car roof
-    glm::mat4 carRoof = glm::translate(glm::mat4(1.0f), glm::vec3(carW.first, 1.0f, carW.second));
-    carRoof = glm::scale(carRoof, glm::vec3(1.6f, 0.4f, 0.8f));
-    shader.setMat4("model", carRoof);
-    shader.setVec3("baseColor", glm::vec3(0.7f, 0.1f, 0.1f)); // Darker red roof
-    glBindVertexArray(cubeMesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
-    
-    // Car headlights
-    glm::mat4 headlight1 = glm::translate(glm::mat4(1.0f), glm::vec3(carW.first + 1.1f, 0.5f, carW.second + 0.3f));
-    headlight1 = glm::scale(headlight1, glm::vec3(0.1f, 0.2f, 0.2f));
-    shader.setMat4("model", headlight1);
-    shader.setVec3("baseColor", glm::vec3(1.0f, 1.0f, 0.9f)); // Bright headlight
-    glBindVertexArray(cubeMesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
-    
-    glm::mat4 headlight2 = glm::translate(glm::mat4(1.0f), glm::vec3(carW.first + 1.1f, 0.5f, carW.second - 0.3f));
-    headlight2 = glm::scale(headlight2, glm::vec3(0.1f, 0.2f, 0.2f));
-    shader.setMat4("model", headlight2);
-    shader.setVec3("baseColor", glm::vec3(1.0f, 1.0f, 0.9f)); // Bright headlight
-    glBindVertexArray(cubeMesh.vao); glDrawElements(GL_TRIANGLES, cubeMesh.elemCount, GL_UNSIGNED_INT, 0); glBindVertexArray(0);
+    // distant buildings as billboards; opaque cutouts, depth tested against the scene
+    impostorBatch.draw(cam.viewMatrix(), proj, impostorAtlas.texture());
 }
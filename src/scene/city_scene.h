@@ -2,12 +2,59 @@
 #define CITY_SCENE_H
 
 #include "../meshes/mesh.h"
+#include "../meshes/mesh_cache.h"
+#include "../meshes/geometry_arena.h"
+#include "../meshes/lod_builder.h"
 #include "../render/shader.h"
+#include "../render/shader_variants.h"
 #include "../render/texture.h"
 #include "../render/camera.h"
+#include "../render/impostor.h"
+#include "../render/frustum.h"
+#include "../render/occlusion_buffer.h"
+#include "../render/light_clusters.h"
+#include "../render/gbuffer.h"
+#include "../render/lightmap.h"
+#include "../render/shadow_cascades.h"
+#include "spatial_grid.h"
+#include "object_store.h"
+#include "transform_store.h"
+#include "traffic.h"
+#include "../render/instance_buffer.h"
+#include "../algorithms/bvh.h"
+#include "../algorithms/road_graph.h"
 #include <vector>
 #include <utility>
 
+// Arena ranges of one building's LOD chain plus its bounding sphere for LOD selection
+struct BuildingLod {
+    ArenaRange levels[kMaxLods];
+    int count = 0;
+    int current = 0;      // level drawn last frame (for hysteresis)
+    AABB bounds;
+    AABB occluder;        // solid base tier, rasterized into the occlusion buffer
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    float footprintRadius = 0.0f; // xz radius, used to pull impostors in front of the geometry
+    float halfExtent = 0.0f;      // half size of the square impostor quad
+    int impostorClass = 0;
+};
+
+// Per-frame counters, shown in the window title
+struct RenderStats {
+    int visibleObjects = 0;
+    int culledObjects = 0;   // outside the frustum
+    int occludedObjects = 0; // in the frustum but hidden behind buildings
+    int impostors = 0;
+    int shadowCascadesDrawn = 0; // camera cascades every frame, + the city one when stale
+};
+
+// How lit surfaces are shaded; both paths share the geometry passes
+enum RenderPath {
+    RENDER_FORWARD,  // lighting per fragment while drawing
+    RENDER_DEFERRED, // attributes into a G-buffer, then one fullscreen light pass
+};
+
 struct CityConfig {
     int citySize;      // 1=Small, 2=Medium, 3=Large
     int numBuildings;  // 5-20
@@ -25,30 +72,95 @@ public:
     ~CityScene();
     bool init(int citySize, int numBuildings, int buildingStyle, float towerW, float towerH, float buildingW, float buildingH, float skyW, float skyH, float pondR, int numSky = 0, int numTow = 0, int numOff = 0);
     void update(float dt);
-    void render(const Shader& shader, const Camera& cam);
+    void render(ShaderVariants& shaders, const Camera& cam);
+    // Feature sets render() uses on a path, for compiling them up front
+    static std::vector<unsigned> shaderVariants(RenderPath path = RENDER_FORWARD);
+    void setRenderPath(RenderPath path) { renderPath = path; }
+    RenderPath getRenderPath() const { return renderPath; }
+    const RenderStats& stats() const { return renderStats; }
+    void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; lastVisible.clear(); }
+    bool occlusionCullingEnabled() const { return occlusionCulling; }
+    glm::mat4 projection(float aspect) const;
+    // Object under the cursor (ndc in [-1,1]); selects and returns its bounds index, or -1
+    int pick(const Camera& cam, float ndcX, float ndcY, float aspect);
+    // True if no building or prop blocks the segment between a and b
+    bool lineOfSight(const glm::vec3& a, const glm::vec3& b);
 private:
-    Mesh cubeMesh;
-    Mesh quadMesh;
-    Mesh pondMesh;
+    MeshCache meshCache;
+    MeshHandle cubeMesh;
+    MeshHandle quadMesh;
+    MeshHandle pondMesh;
+    Mesh roadMesh; // all road runs merged into strips
+    GeometryArena buildingArena;               // world-space geometry of every building
+    std::vector<BuildingLod> buildingLods;     // per building, indexed like the building table
+    std::vector<ArenaRange> buildingsByType[3]; // per-frame draw lists, one multi-draw per texture
+    std::vector<std::pair<ArenaRange, float>> fadingByType[3]; // per frame: buildings dissolving into impostors
+    ImpostorAtlas impostorAtlas;               // pre-rendered views per type/height class
+    ImpostorBatch impostorBatch;               // far buildings as billboards
+    std::vector<size_t> impostorClassReps;     // building rendered into each atlas row
+    bool impostorsBuilt = false;
+
+    // world-space bounds of every object: the store's objects by dense ID (its tables
+    // in ObjectKind order), then [pond][roads]; culled each frame
+    AABBList objectBounds;
+    size_t pondBoundsIndex = 0, roadBoundsIndex = 0;
+    std::vector<uint8_t> objectVisible;
+    RenderStats renderStats;
+    SpatialGrid spatialGrid; // object IDs = objectBounds indices, bucketed per tile
+    BVH objectBVH;           // buildings + props (everything before the pond), for ray queries
+    bool bvhDirty = false;   // a pickable object moved; refit before the next query
+    int selectedObject = -1;
+    // culling scratch, reused every frame
+    std::vector<uint32_t> tileInside, tilePartial;
+    AABBList partialBounds;
+    std::vector<uint8_t> partialVisible;
+    // occlusion culling: last frame's visible buildings are this frame's occluders
+    OcclusionBuffer occlusionBuffer;
+    std::vector<uint8_t> lastVisible;
+    std::vector<std::pair<float, uint32_t>> occluderOrder;
+    bool occlusionCulling = true;
+    // street lamps + headlights, binned into view clusters every frame
+    std::vector<PointLight> sceneLights;
+    LightClusters lightClusters;
+    Lightmap lightmap; // lamps + ambient on the ground, roads and facades, baked at load
+    ShadowCascades shadows; // moonlight
+    std::vector<uint8_t> shadowVisible;   // per cascade culling scratch
+    std::vector<ArenaRange> shadowRanges;
+    RenderPath renderPath = RENDER_FORWARD;
+    GBuffer gbuffer;
+    // per-frame camera uniforms, set on each shader variant as it is bound
+    glm::mat4 frameView = glm::mat4(1.0f), frameProj = glm::mat4(1.0f);
+    glm::vec3 frameEye = glm::vec3(0.0f);
+    unsigned framePass = 0; // SHADER_GBUFFER while filling the G-buffer, added to every variant
     GLuint buildingTex = 0;
     GLuint towerTex = 0;
     GLuint skyscraperTex = 0;
     GLuint roadTex = 0;
     GLuint pondTex = 0;
 
-    // procedural placement
+    // procedural placement: buildings (type 0=skyscraper, 1=tower, 2=office), trees,
+    // street lamps and cars live in the object store
     std::vector<std::pair<int,int>> roadCells;
-    std::vector<std::pair<int,int>> buildingCells;
-    std::vector<float> buildingHeights;
-    std::vector<int> buildingTypes; // 0=skyscraper, 1=tower, 2=office
-    std::vector<std::pair<int,int>> treeCells;
-    std::vector<std::pair<int,int>> streetLamps;
-    std::pair<int,int> carPosition;
+    ObjectStore objects;
+    // Prop hierarchy: every object of a kind with parts has a root transform
+    // (rootTransforms[kind] + row: position + heading), and each cube part (see
+    // kPropParts) is its child at partTransforms[p] + row. Roots come before parts, so
+    // one update() pass moves whole composites; visible rows map to runs of instances.
+    TransformStore transforms;
+    uint32_t rootTransforms[OBJECT_KIND_COUNT] = {};
+    std::vector<uint32_t> partTransforms;
+    InstanceBuffer propInstances;
+    // road network topology over roadCells, and cars driving it: traffic car i is
+    // trafficCars[i] in the car table
+    RoadGraph roadGraph;
+    LaneGraph laneGraph;
+    TrafficSim traffic;
+    std::vector<ObjectHandle> trafficCars;
+    size_t headlightStart = 0; // first headlight in sceneLights, two per car
     int pond_cx, pond_cy, pond_r;
     CityConfig config;
     int gridSize;
-    float waterTime;
-    float ripplePhase;
+    float waterTime; // seconds scaled by the animation speed, the water shaders' time uniform
     std::vector<std::vector<bool>> occupiedGrid;
     // helper
     std::pair<float,float> cellToWorld(int i, int j) const;
@@ -58,7 +170,29 @@ private:
     void placeBuildingsRandomly();
     void placeTrees();
     void placeStreetLamps();
-    void placeRandomCar();
+    void placeTraffic();
+    void buildBuildingGeometry();
+    GLuint buildingTexture(int type) const;
+    void buildImpostors(ShaderVariants& shaders);
+    const Shader& bindShader(ShaderVariants& shaders, unsigned features) const;
+    void drawCube(const Shader& shader, const glm::mat4& model, const glm::vec3& color) const;
+    void buildPropTransforms();
+    glm::mat4 objectTransform(ObjectKind kind, size_t row) const;
+    void moveObject(ObjectHandle h, const glm::vec3& position, float heading);
+    void drawProps(const Shader& props, const std::vector<uint8_t>& visible, bool emissive, bool staticOnly) const;
+    AABB shadowBounds() const;
+    void renderShadows(ShaderVariants& shaders, float aspect);
+    void lightGBuffer(ShaderVariants& shaders);
+    void buildObjectBounds();
+    void buildLights();
+    void placeHeadlights();
+    void bakeLightmap();
+    size_t addObjectBounds(const AABB& box);
+    void setObjectBounds(size_t id, const AABB& box);
+    void buildObjectBVH();
+    const BVH& objectQueries();
+    void cullObjects(const glm::mat4& viewProj);
+    void occludeObjects(const glm::mat4& viewProj, const glm::vec3& eye, float aspect);
     float getFuturisticHeight(int type, int index);
     glm::vec3 getFuturisticColor(int type);
 };
@@ -0,0 +1,116 @@
+#include "object_store.h"
+#include <cassert>
+#include <cmath>
+
+AABB ObjectStore::Table::bounds(size_t row) const {
+    float hx = ex[row], hz = ez[row];
+    if (heading[row] != 0.0f) {
+        // footprint of the turned box
+        float c = std::fabs(std::cos(heading[row])), s = std::fabs(std::sin(heading[row]));
+        hx = c * ex[row] + s * ez[row];
+        hz = s * ex[row] + c * ez[row];
+    }
+    AABB b;
+    b.min = glm::vec3(x[row] - hx, y[row], z[row] - hz);
+    b.max = glm::vec3(x[row] + hx, y[row] + ey[row], z[row] + hz);
+    return b;
+}
+
+ObjectHandle ObjectStore::add(ObjectKind kind, const glm::vec3& position, const glm::vec3& extents,
+                              uint8_t type, uint8_t material, uint8_t flags) {
+    uint32_t s;
+    if (!freeSlots.empty()) {
+        s = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        s = (uint32_t)slots.size();
+        slots.push_back(Slot());
+    }
+    Table& t = tables[kind];
+    Slot& slot = slots[s];
+    slot.kind = (uint8_t)kind;
+    slot.row = (uint32_t)t.size();
+    slot.live = true;
+
+    t.x.push_back(position.x); t.y.push_back(position.y); t.z.push_back(position.z);
+    t.ex.push_back(extents.x); t.ey.push_back(extents.y); t.ez.push_back(extents.z);
+    t.heading.push_back(0.0f);
+    t.type.push_back(type);
+    t.material.push_back(material);
+    t.flags.push_back(flags);
+    t.slot.push_back(s);
+
+    ObjectHandle h;
+    h.slot = s;
+    h.generation = slot.generation;
+    return h;
+}
+
+void ObjectStore::clear() {
+    for (auto& t : tables) t = Table();
+    // bump every generation so handles from before the clear stay invalid
+    freeSlots.clear();
+    for (uint32_t s = 0; s < slots.size(); s++) {
+        if (slots[s].live) slots[s].generation++;
+        slots[s].live = false;
+        freeSlots.push_back((uint32_t)slots.size() - 1 - s);
+    }
+}
+
+bool ObjectStore::valid(ObjectHandle h) const {
+    return h.slot < slots.size() && slots[h.slot].live && slots[h.slot].generation == h.generation;
+}
+
+ObjectHandle ObjectStore::handle(ObjectKind kind, size_t row) const {
+    assert(row < tables[kind].size());
+    ObjectHandle h;
+    h.slot = tables[kind].slot[row];
+    h.generation = slots[h.slot].generation;
+    return h;
+}
+
+void ObjectStore::setPosition(ObjectHandle h, const glm::vec3& position) {
+    if (!valid(h)) return;
+    Table& t = tables[slots[h.slot].kind];
+    size_t row = slots[h.slot].row;
+    t.x[row] = position.x;
+    t.y[row] = position.y;
+    t.z[row] = position.z;
+}
+
+void ObjectStore::setHeading(ObjectHandle h, float heading) {
+    if (!valid(h)) return;
+    tables[slots[h.slot].kind].heading[slots[h.slot].row] = heading;
+}
+
+void ObjectStore::setBounds(ObjectHandle h, const AABB& box) {
+    if (!valid(h)) return;
+    Table& t = tables[slots[h.slot].kind];
+    size_t row = slots[h.slot].row;
+    t.x[row] = (box.min.x + box.max.x) * 0.5f;
+    t.y[row] = box.min.y;
+    t.z[row] = (box.min.z + box.max.z) * 0.5f;
+    t.ex[row] = (box.max.x - box.min.x) * 0.5f;
+    t.ey[row] = box.max.y - box.min.y;
+    t.ez[row] = (box.max.z - box.min.z) * 0.5f;
+}
+
+size_t ObjectStore::size() const {
+    size_t n = 0;
+    for (auto& t : tables) n += t.size();
+    return n;
+}
+
+size_t ObjectStore::firstId(ObjectKind kind) const {
+    size_t n = 0;
+    for (int k = 0; k < kind; k++) n += tables[k].size();
+    return n;
+}
+
+ObjectKind ObjectStore::kindOfId(size_t id) const {
+    for (int k = 0; k < OBJECT_KIND_COUNT; k++) {
+        if (id < tables[k].size()) return (ObjectKind)k;
+        id -= tables[k].size();
+    }
+    return OBJECT_KIND_COUNT;
+}
@@ -0,0 +1,88 @@
+#ifndef OBJECT_STORE_H
+#define OBJECT_STORE_H
+
+#include "../render/frustum.h"
+#include <glm/glm.hpp>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// Kinds of placed objects, one table each. Table order is also the order of the
+// dense object IDs (see ObjectStore::firstId), so per-kind loops over visibility or
+// bounds arrays stay contiguous.
+enum ObjectKind {
+    OBJECT_BUILDING,
+    OBJECT_TREE,
+    OBJECT_LAMP,
+    OBJECT_CAR,
+    OBJECT_KIND_COUNT
+};
+
+enum ObjectFlags : uint8_t {
+    OBJECT_STATIC = 1 << 0, // never moves: baked into the lightmap and the cached shadow cascade
+};
+
+// Stable reference to an object. Slots are reused with a new generation after a
+// clear(), so handles from before it stay invalid.
+struct ObjectHandle {
+    uint32_t slot = ~0u;
+    uint32_t generation = 0;
+};
+
+// Scene objects stored structure-of-arrays, one table per kind. Rows are packed, so
+// per-frame loops read each column linearly. Objects are only ever added (or all
+// cleared): rows are dense IDs that the scene's bounds, grid, BVH, LODs, lightmap
+// charts and transforms are indexed by, so removing one would have to remap those. Position is the center of the object's footprint at its base; extents
+// are half width, full height and half depth before the object's heading (a turn
+// about +y) is applied, which gives the world bounds.
+class ObjectStore {
+public:
+    struct Table {
+        std::vector<float> x, y, z;         // base center
+        std::vector<float> ex, ey, ez;      // half width, height, half depth
+        std::vector<float> heading;         // radians about +y; local +x turns towards -z
+        std::vector<uint8_t> type;          // per-kind subtype, e.g. building style
+        std::vector<uint8_t> material;      // texture / color slot used when drawing
+        std::vector<uint8_t> flags;         // ObjectFlags
+        std::vector<uint32_t> slot;         // owning handle slot, for handle(kind, row)
+        size_t size() const { return x.size(); }
+        glm::vec3 position(size_t row) const { return glm::vec3(x[row], y[row], z[row]); }
+        AABB bounds(size_t row) const;
+    };
+
+    ObjectHandle add(ObjectKind kind, const glm::vec3& position, const glm::vec3& extents,
+                     uint8_t type = 0, uint8_t material = 0, uint8_t flags = OBJECT_STATIC);
+    void clear();
+    bool valid(ObjectHandle h) const;
+
+    ObjectKind kind(ObjectHandle h) const { assert(valid(h)); return (ObjectKind)slots[h.slot].kind; }
+    size_t row(ObjectHandle h) const { assert(valid(h)); return slots[h.slot].row; }
+    ObjectHandle handle(ObjectKind kind, size_t row) const;
+
+    // Setters ignore invalid (stale) handles
+    void setPosition(ObjectHandle h, const glm::vec3& position);
+    void setHeading(ObjectHandle h, float heading);
+    // Position + extents from a world box (e.g. the generated mesh's bounds)
+    void setBounds(ObjectHandle h, const AABB& box);
+
+    const Table& table(ObjectKind kind) const { return tables[kind]; }
+    size_t count(ObjectKind kind) const { return tables[kind].size(); }
+    size_t size() const;
+    // Dense IDs: the tables back to back in ObjectKind order
+    size_t firstId(ObjectKind kind) const;
+    size_t id(ObjectKind kind, size_t row) const { return firstId(kind) + row; }
+    // Table an ID falls in (OBJECT_KIND_COUNT past the last object)
+    ObjectKind kindOfId(size_t id) const;
+private:
+    struct Slot {
+        uint32_t generation = 0;
+        uint32_t row = 0;
+        uint8_t kind = 0;
+        bool live = false;
+    };
+    Table tables[OBJECT_KIND_COUNT];
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
+
+#endif // OBJECT_STORE_H
@@ -0,0 +1,164 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+
+void SpatialGrid::init(int gridCells, int tileCells, float ox, float oz) {
+    tileSize = (float)std::max(tileCells, 1);
+    tileCountX = tileCountZ = std::max(1, (gridCells + tileCells - 1) / std::max(tileCells, 1));
+    originX = ox;
+    originZ = oz;
+    clear();
+}
+
+void SpatialGrid::clear() {
+    tiles.assign((size_t)tileCountX * tileCountZ, std::vector<uint32_t>());
+    tileMaxY.assign(tiles.size(), 0.0f);
+    spans.clear();
+    seen.clear();
+    queryStamp = 0;
+}
+
+SpatialGrid::Span SpatialGrid::spanOf(const AABB& box) const {
+    Span s;
+    s.x0 = std::max(0, std::min(tileCountX - 1, (int)std::floor((box.min.x - originX) / tileSize)));
+    s.z0 = std::max(0, std::min(tileCountZ - 1, (int)std::floor((box.min.z - originZ) / tileSize)));
+    s.x1 = std::max(0, std::min(tileCountX - 1, (int)std::floor((box.max.x - originX) / tileSize)));
+    s.z1 = std::max(0, std::min(tileCountZ - 1, (int)std::floor((box.max.z - originZ) / tileSize)));
+    return s;
+}
+
+bool SpatialGrid::querySpan(float minX, float minZ, float maxX, float maxZ, Span& s) const {
+    if (tiles.empty()) return false;
+    float extentX = tileCountX * tileSize, extentZ = tileCountZ * tileSize;
+    if (maxX < originX || maxZ < originZ || minX >= originX + extentX || minZ >= originZ + extentZ) return false;
+    AABB r;
+    r.min = glm::vec3(minX, 0.0f, minZ);
+    r.max = glm::vec3(maxX, 0.0f, maxZ);
+    s = spanOf(r);
+    return true;
+}
+
+void SpatialGrid::addToTiles(uint32_t id, const Span& s, float maxY) {
+    for (int tz = s.z0; tz <= s.z1; tz++) {
+        for (int tx = s.x0; tx <= s.x1; tx++) {
+            size_t t = (size_t)tz * tileCountX + tx;
+            tiles[t].push_back(id);
+            tileMaxY[t] = std::max(tileMaxY[t], maxY);
+        }
+    }
+}
+
+void SpatialGrid::removeFromTiles(uint32_t id, const Span& s) {
+    for (int tz = s.z0; tz <= s.z1; tz++) {
+        for (int tx = s.x0; tx <= s.x1; tx++) {
+            auto& list = tiles[(size_t)tz * tileCountX + tx];
+            auto it = std::find(list.begin(), list.end(), id);
+            if (it != list.end()) { *it = list.back(); list.pop_back(); } // order does not matter
+        }
+    }
+}
+
+void SpatialGrid::insert(uint32_t id, const AABB& box) {
+    if (spans.size() <= id) {
+        spans.resize(id + 1);
+        seen.resize(id + 1, 0);
+    }
+    spans[id] = spanOf(box);
+    addToTiles(id, spans[id], box.max.y);
+}
+
+void SpatialGrid::remove(uint32_t id) {
+    if (id >= spans.size()) return;
+    removeFromTiles(id, spans[id]);
+    spans[id] = Span();
+}
+
+void SpatialGrid::update(uint32_t id, const AABB& box) {
+    if (id >= spans.size()) { insert(id, box); return; }
+    Span s = spanOf(box);
+    const Span& old = spans[id];
+    if (s.x0 == old.x0 && s.z0 == old.z0 && s.x1 == old.x1 && s.z1 == old.z1) {
+        for (int tz = s.z0; tz <= s.z1; tz++)
+            for (int tx = s.x0; tx <= s.x1; tx++) {
+                float& y = tileMaxY[(size_t)tz * tileCountX + tx];
+                y = std::max(y, box.max.y);
+            }
+        return;
+    }
+    removeFromTiles(id, old);
+    spans[id] = s;
+    addToTiles(id, s, box.max.y);
+}
+
+uint32_t SpatialGrid::nextStamp() const {
+    if (++queryStamp == 0) { // wrapped: reset all stamps
+        std::fill(seen.begin(), seen.end(), 0);
+        queryStamp = 1;
+    }
+    return queryStamp;
+}
+
+void SpatialGrid::collectTile(int tx, int tz, std::vector<uint32_t>& out) const {
+    for (uint32_t id : tiles[(size_t)tz * tileCountX + tx]) {
+        if (seen[id] == queryStamp) continue;
+        seen[id] = queryStamp;
+        out.push_back(id);
+    }
+}
+
+void SpatialGrid::queryRect(float minX, float minZ, float maxX, float maxZ, std::vector<uint32_t>& out) const {
+    Span s;
+    if (!querySpan(minX, minZ, maxX, maxZ, s)) return;
+    nextStamp();
+    for (int tz = s.z0; tz <= s.z1; tz++)
+        for (int tx = s.x0; tx <= s.x1; tx++) collectTile(tx, tz, out);
+}
+
+void SpatialGrid::queryRadius(float x, float z, float radius, std::vector<uint32_t>& out) const {
+    queryRect(x - radius, z - radius, x + radius, z + radius, out);
+}
+
+void SpatialGrid::queryFrustum(const Frustum& f, float minX, float minZ, float maxX, float maxZ,
+                               std::vector<uint32_t>& inside, std::vector<uint32_t>& partial) const {
+    Span s;
+    if (!querySpan(minX, minZ, maxX, maxZ, s)) return;
+    nextStamp();
+    for (int tz = s.z0; tz <= s.z1; tz++) {
+        for (int tx = s.x0; tx <= s.x1; tx++) {
+            size_t t = (size_t)tz * tileCountX + tx;
+            if (tiles[t].empty()) continue;
+            // every object overlapping this tile has some part inside these bounds
+            AABB tb;
+            tb.min = glm::vec3(originX + tx * tileSize, 0.0f, originZ + tz * tileSize);
+            tb.max = glm::vec3(originX + (tx + 1) * tileSize, tileMaxY[t], originZ + (tz + 1) * tileSize);
+            int c = f.classify(tb);
+            if (c == Frustum::Outside) continue;
+            collectTile(tx, tz, c == Frustum::Inside ? inside : partial);
+        }
+    }
+}
+
+void SpatialGrid::queryRay(const glm::vec3& origin, const glm::vec3& dir, float maxDist, std::vector<uint32_t>& out) const {
+    if (tiles.empty()) return;
+    nextStamp();
+    // Amanatides-Woo traversal in tile space
+    float px = (origin.x - originX) / tileSize, pz = (origin.z - originZ) / tileSize;
+    float dx = dir.x, dz = dir.z;
+    int tx = (int)std::floor(px), tz = (int)std::floor(pz);
+    int stepX = dx > 0 ? 1 : -1, stepZ = dz > 0 ? 1 : -1;
+    const float inf = 1e30f;
+    float tDeltaX = dx != 0.0f ? std::fabs(tileSize / dx) : inf;
+    float tDeltaZ = dz != 0.0f ? std::fabs(tileSize / dz) : inf;
+    float tMaxX = dx != 0.0f ? ((dx > 0 ? (tx + 1 - px) : (px - tx)) * tileSize) / std::fabs(dx) : inf;
+    float tMaxZ = dz != 0.0f ? ((dz > 0 ? (tz + 1 - pz) : (pz - tz)) * tileSize) / std::fabs(dz) : inf;
+    float t = 0.0f;
+    while (t <= maxDist) {
+        // outside the grid and moving away from it on some axis: nothing more to find
+        bool awayX = tx < 0 ? (dx == 0.0f || stepX < 0) : tx >= tileCountX ? (dx == 0.0f || stepX > 0) : false;
+        bool awayZ = tz < 0 ? (dz == 0.0f || stepZ < 0) : tz >= tileCountZ ? (dz == 0.0f || stepZ > 0) : false;
+        if (awayX || awayZ) break;
+        if (tx >= 0 && tx < tileCountX && tz >= 0 && tz < tileCountZ) collectTile(tx, tz, out);
+        if (tMaxX < tMaxZ) { t = tMaxX; tMaxX += tDeltaX; tx += stepX; }
+        else               { t = tMaxZ; tMaxZ += tDeltaZ; tz += stepZ; }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "../render/frustum.h"
+#include <cstdint>
+#include <vector>
+
+// Uniform grid over the city's XZ plane. Each tile covers tileCells x tileCells
+// grid cells and keeps a compact list of the object IDs whose bounds overlap it,
+// plus the tile's height range so whole tiles can be frustum-tested. Objects past the
+// grid's edge are kept in the edge tiles; queries that miss the grid find nothing.
+class SpatialGrid {
+public:
+    void init(int gridCells, int tileCells, float originX, float originZ);
+    void clear();
+
+    void insert(uint32_t id, const AABB& box);
+    void remove(uint32_t id);
+    // Moves an object; tile lists are only touched when its tile span changes
+    void update(uint32_t id, const AABB& box);
+
+    // Objects overlapping an XZ rectangle (each ID reported once)
+    void queryRect(float minX, float minZ, float maxX, float maxZ, std::vector<uint32_t>& out) const;
+    void queryRadius(float x, float z, float radius, std::vector<uint32_t>& out) const;
+
+    // Frustum query over the tiles inside [minX,maxX]x[minZ,maxZ] (the frustum's XZ
+    // footprint). Objects in tiles fully inside the frustum go to `inside` and need no
+    // further test; objects in tiles crossing a plane go to `partial`.
+    void queryFrustum(const Frustum& f, float minX, float minZ, float maxX, float maxZ,
+                      std::vector<uint32_t>& inside, std::vector<uint32_t>& partial) const;
+
+    // Objects in the tiles a ray crosses (2D DDA over tiles), nearest tiles first
+    void queryRay(const glm::vec3& origin, const glm::vec3& dir, float maxDist, std::vector<uint32_t>& out) const;
+
+    int tilesX() const { return tileCountX; }
+    int tilesZ() const { return tileCountZ; }
+    const std::vector<uint32_t>& tile(int tx, int tz) const { return tiles[tz * tileCountX + tx]; }
+private:
+    struct Span { int x0 = 0, z0 = 0, x1 = -1, z1 = -1; };
+    int tileCountX = 0, tileCountZ = 0;
+    float tileSize = 8.0f;
+    float originX = 0.0f, originZ = 0.0f;
+    std::vector<std::vector<uint32_t>> tiles;
+    std::vector<float> tileMaxY;        // highest object top per tile (conservative)
+    std::vector<Span> spans;            // per object ID
+    mutable std::vector<uint32_t> seen; // per object ID query stamp, for de-duplication
+    mutable uint32_t queryStamp = 0;
+
+    Span spanOf(const AABB& box) const;   // clamped to the grid
+    // Tiles a query rectangle covers; false if it misses the grid entirely
+    bool querySpan(float minX, float minZ, float maxX, float maxZ, Span& s) const;
+    void addToTiles(uint32_t id, const Span& s, float maxY);
+    void removeFromTiles(uint32_t id, const Span& s);
+    void collectTile(int tx, int tz, std::vector<uint32_t>& out) const;
+    uint32_t nextStamp() const;
+};
+
+#endif // SPATIAL_GRID_H
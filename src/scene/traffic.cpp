@@ -0,0 +1,240 @@
+#include "traffic.h"
+#include "../core/worker_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// cars per parallel chunk; lanes per chunk for the per-lane passes
+static const size_t kCarGrain = 2048;
+static const size_t kLaneGrain = 64;
+
+static void runChunks(WorkerPool* pool, size_t count, const std::function<void(size_t, size_t)>& fn, size_t grain) {
+    if (pool) pool->parallelFor(count, fn, grain);
+    else fn(0, count);
+}
+
+void LaneGraph::build(const RoadGraph& roads, float laneOffset) {
+    laneList.clear();
+    next.clear();
+    const std::vector<RoadGraph::Edge>& edges = roads.edges();
+    const std::vector<glm::vec2>& points = roads.points();
+
+    // each road edge, both ways: one lane per straight piece of its polyline, on the
+    // right-hand side; lanes of (edge, dir) are consecutive from chainFirst[edge * 2 + dir]
+    std::vector<uint32_t> chainFirst(edges.size() * 2 + 1);
+    std::vector<uint32_t> chainEnd;   // per lane: the node its chain ends at, or ~0u mid-chain
+    std::vector<uint32_t> chainOf;    // per lane: edge * 2 + dir
+    for (uint32_t e = 0; e < edges.size(); e++) {
+        for (int dir = 0; dir < 2; dir++) {
+            chainFirst[e * 2 + dir] = (uint32_t)laneList.size();
+            const RoadGraph::Edge& edge = edges[e];
+            for (uint32_t k = 0; k + 1 < edge.pointCount; k++) {
+                uint32_t ia = edge.firstPoint + (dir ? edge.pointCount - 1 - k : k);
+                uint32_t ib = dir ? ia - 1 : ia + 1;
+                glm::vec2 wa = points[ia], wb = points[ib];
+                Lane lane;
+                lane.length = glm::length(wb - wa);
+                lane.dir = (wb - wa) / lane.length;
+                lane.start = wa + glm::vec2(-lane.dir.y, lane.dir.x) * laneOffset;
+                lane.heading = std::atan2(-lane.dir.y, lane.dir.x);
+                laneList.push_back(lane);
+                chainEnd.push_back(k + 2 == edge.pointCount ? (dir ? edge.from : edge.to) : ~0u);
+                chainOf.push_back(e * 2 + dir);
+            }
+        }
+    }
+    chainFirst.back() = (uint32_t)laneList.size();
+
+    // successors: the next piece along the edge; at its end node, every chain leaving the
+    // node except the way back, unless that's all there is
+    std::vector<uint32_t> leaving;
+    for (size_t l = 0; l < laneList.size(); l++) {
+        laneList[l].firstNext = (uint32_t)next.size();
+        uint32_t node = chainEnd[l];
+        if (node == ~0u) {
+            next.push_back((uint32_t)l + 1);
+        } else {
+            leaving.clear();
+            const uint32_t* at = roads.edgesAt(node);
+            for (uint32_t k = 0; k < roads.degree(node); k++) {
+                if (edges[at[k]].from == node) leaving.push_back(at[k] * 2);
+                if (edges[at[k]].to == node) leaving.push_back(at[k] * 2 + 1);
+            }
+            std::sort(leaving.begin(), leaving.end());
+            leaving.erase(std::unique(leaving.begin(), leaving.end()), leaving.end()); // loops
+            uint32_t back = chainOf[l] ^ 1u;
+            for (uint32_t c : leaving)
+                if ((c != back || leaving.size() == 1) && chainFirst[c] < chainFirst[c + 1])
+                    next.push_back(chainFirst[c]);
+        }
+        laneList[l].nextCount = (uint32_t)next.size() - laneList[l].firstNext;
+    }
+}
+
+float LaneGraph::totalLength() const {
+    float total = 0.0f;
+    for (auto& l : laneList) total += l.length;
+    return total;
+}
+
+size_t TrafficSim::spawn(const LaneGraph& g, size_t count, uint32_t seed, const TrafficParams& p) {
+    graph = &g;
+    params = p;
+    x.clear(); z.clear(); heading.clear();
+    lane.clear(); nextLane.clear(); s.clear(); v.clear(); rng.clear();
+    const std::vector<LaneGraph::Lane>& lanes = g.lanes();
+    if (lanes.empty() || count == 0) return 0;
+
+    // even spacing along all lanes laid end to end, never closer than a jam
+    float spacing = std::max(g.totalLength() / count, p.carLength + p.minGap);
+    float d = spacing * 0.5f;
+    for (uint32_t l = 0; l < lanes.size() && s.size() < count; l++) {
+        for (; d < lanes[l].length && s.size() < count; d += spacing) {
+            lane.push_back(l);
+            s.push_back(d);
+            v.push_back(p.desiredSpeed * 0.5f);
+            uint32_t state = (seed + (uint32_t)s.size()) * 2654435761u;
+            rng.push_back(state ? state : 1u);
+        }
+        d -= lanes[l].length;
+    }
+    size_t n = s.size();
+    nextLane.resize(n);
+    x.resize(n); z.resize(n); heading.resize(n);
+    gap.resize(n); dv.resize(n);
+    order.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        order[i] = (uint32_t)i;
+        nextLane[i] = chooseNext(i, lane[i]);
+        place(i);
+    }
+    return n;
+}
+
+uint32_t TrafficSim::chooseNext(size_t i, uint32_t fromLane) {
+    const LaneGraph::Lane& l = graph->lanes()[fromLane];
+    if (l.nextCount == 0) return fromLane; // isolated stretch: start over
+    uint32_t r = rng[i];
+    r ^= r << 13; r ^= r >> 17; r ^= r << 5;
+    rng[i] = r;
+    return graph->successors()[l.firstNext + r % l.nextCount];
+}
+
+void TrafficSim::place(size_t i) {
+    const LaneGraph::Lane& l = graph->lanes()[lane[i]];
+    x[i] = l.start.x + l.dir.x * s[i];
+    z[i] = l.start.y + l.dir.y * s[i];
+    heading[i] = l.heading;
+}
+
+void TrafficSim::sortByLane(WorkerPool* pool) {
+    // stable counting sort in last step's order, so each lane stays nearly sorted by s
+    size_t laneCount = graph->lanes().size();
+    laneFirst.assign(laneCount + 1, 0);
+    for (uint32_t l : lane) laneFirst[l + 1]++;
+    for (size_t l = 0; l < laneCount; l++) laneFirst[l + 1] += laneFirst[l];
+    laneCursor.assign(laneFirst.begin(), laneFirst.end() - 1);
+    previousOrder.swap(order);
+    order.resize(previousOrder.size());
+    for (uint32_t i : previousOrder) order[laneCursor[lane[i]]++] = i;
+
+    runChunks(pool, laneCount, [&](size_t begin, size_t end) {
+        for (size_t l = begin; l < end; l++) {
+            for (uint32_t k = laneFirst[l] + 1; k < laneFirst[l + 1]; k++) {
+                uint32_t car = order[k];
+                uint32_t j = k;
+                for (; j > laneFirst[l] && s[order[j - 1]] > s[car]; j--) order[j] = order[j - 1];
+                order[j] = car;
+            }
+        }
+    }, kLaneGrain);
+}
+
+void TrafficSim::findLeaders(WorkerPool* pool) {
+    const std::vector<LaneGraph::Lane>& lanes = graph->lanes();
+    // merges: of the front cars about to enter the same lane, the one nearest the end
+    // of its lane goes first and the others queue behind it (zipper order); serial, as
+    // several lanes can feed the same target
+    mergeFront.assign(lanes.size(), ~0u);
+    mergeDistance.assign(lanes.size(), 1e30f);
+    for (size_t l = 0; l < lanes.size(); l++) {
+        if (laneFirst[l] == laneFirst[l + 1]) continue;
+        uint32_t front = order[laneFirst[l + 1] - 1];
+        uint32_t target = nextLane[front];
+        float remaining = lanes[l].length - s[front];
+        if (remaining < mergeDistance[target]) {
+            mergeDistance[target] = remaining;
+            mergeFront[target] = front;
+        }
+    }
+    runChunks(pool, lanes.size(), [&](size_t begin, size_t end) {
+        for (size_t l = begin; l < end; l++) {
+            for (uint32_t k = laneFirst[l]; k < laneFirst[l + 1]; k++) {
+                uint32_t i = order[k];
+                gap[i] = 1e4f; // free road
+                dv[i] = 0.0f;
+                if (k + 1 < laneFirst[l + 1]) {
+                    uint32_t leader = order[k + 1];
+                    gap[i] = s[leader] - s[i] - params.carLength;
+                    dv[i] = v[i] - v[leader];
+                    continue;
+                }
+                // front of its lane: follow the rearmost car on the lane it turns into...
+                uint32_t nl = nextLane[i];
+                float remaining = lanes[l].length - s[i];
+                if (laneFirst[nl] < laneFirst[nl + 1] && order[laneFirst[nl]] != i) {
+                    uint32_t leader = order[laneFirst[nl]];
+                    gap[i] = remaining + s[leader] - params.carLength;
+                    dv[i] = v[i] - v[leader];
+                }
+                // ...or the car merging into it ahead of this one, whichever is closer
+                uint32_t first = mergeFront[nl];
+                if (first != i && first != ~0u && remaining - mergeDistance[nl] - params.carLength < gap[i]) {
+                    gap[i] = remaining - mergeDistance[nl] - params.carLength;
+                    dv[i] = v[i] - v[first];
+                }
+            }
+        }
+    }, kLaneGrain);
+}
+
+void TrafficSim::step(float dt, WorkerPool* pool) {
+    size_t n = s.size();
+    if (n == 0) return;
+    sortByLane(pool);
+    findLeaders(pool);
+
+    // IDM: a = a_max * (1 - (v/v0)^4 - (s*(v, dv) / gap)^2), branch-free over packed arrays
+    const float invV0 = 1.0f / params.desiredSpeed;
+    const float T = params.timeHeadway, s0 = params.minGap, aMax = params.maxAccel;
+    const float invTwoSqrtAB = 1.0f / (2.0f * std::sqrt(params.maxAccel * params.comfortDecel));
+    runChunks(pool, n, [&](size_t begin, size_t end) {
+        float* vp = v.data();
+        float* sp = s.data();
+        const float* gp = gap.data();
+        const float* dp = dv.data();
+        for (size_t i = begin; i < end; i++) {
+            float vi = vp[i];
+            float r = vi * invV0;
+            float desiredGap = s0 + std::max(0.0f, vi * T + vi * dp[i] * invTwoSqrtAB);
+            float q = desiredGap / std::max(gp[i], 0.1f);
+            float a = aMax * (1.0f - r * r * r * r - q * q);
+            float nv = std::max(0.0f, vi + a * dt);
+            sp[i] += (vi + nv) * 0.5f * dt;
+            vp[i] = nv;
+        }
+    }, kCarGrain);
+
+    // lane changes at lane ends, then the world placement
+    const std::vector<LaneGraph::Lane>& lanes = graph->lanes();
+    runChunks(pool, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            while (s[i] >= lanes[lane[i]].length) {
+                s[i] -= lanes[lane[i]].length;
+                lane[i] = nextLane[i];
+                nextLane[i] = chooseNext(i, lane[i]);
+            }
+            place(i);
+        }
+    }, kCarGrain);
+}
@@ -0,0 +1,77 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include "../algorithms/road_graph.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class WorkerPool;
+
+// Directed lanes over a road graph. Each straight piece of an edge's polyline becomes
+// one lane per direction, offset to the right-hand side of the road. A lane's
+// successors are the lanes leaving its end node; turning back is only allowed at dead ends.
+class LaneGraph {
+public:
+    struct Lane {
+        glm::vec2 start = glm::vec2(0.0f), dir = glm::vec2(1.0f, 0.0f); // world xz, unit direction
+        float length = 0.0f;
+        float heading = 0.0f;         // object heading of a car driving it (see ObjectStore::Table)
+        uint32_t firstNext = 0, nextCount = 0; // into successors()
+    };
+
+    void build(const RoadGraph& roads, float laneOffset = 0.25f);
+    const std::vector<Lane>& lanes() const { return laneList; }
+    const std::vector<uint32_t>& successors() const { return next; }
+    float totalLength() const;
+private:
+    std::vector<Lane> laneList;
+    std::vector<uint32_t> next;
+};
+
+// Intelligent Driver Model parameters (lengths in world units, times in seconds)
+struct TrafficParams {
+    float desiredSpeed = 8.0f;
+    float timeHeadway = 1.2f;
+    float maxAccel = 1.5f;
+    float comfortDecel = 2.5f;
+    float minGap = 1.0f;
+    float carLength = 2.2f; // bumper to bumper, gaps are measured between bumpers
+};
+
+// Cars on a lane graph, stored structure-of-arrays. Each step sorts the cars by lane
+// and distance (counting sort + insertion sort, as the order barely changes between
+// steps), finds each car's leader, then runs the IDM acceleration as a branch-free
+// loop over packed floats. The per-lane sorts, leader search, IDM and lane advance
+// run in parallel chunks on a worker pool; the counting sort and the merge table
+// are single linear passes and stay serial.
+class TrafficSim {
+public:
+    // Spreads up to `count` cars evenly over the lanes at no less than the jam spacing;
+    // returns how many were placed
+    size_t spawn(const LaneGraph& graph, size_t count, uint32_t seed, const TrafficParams& params = TrafficParams());
+    void step(float dt, WorkerPool* pool = nullptr);
+    size_t size() const { return s.size(); }
+
+    // per car, valid after spawn() / step(): world xz of the car's center and its heading
+    std::vector<float> x, z, heading;
+    // per car simulation state
+    std::vector<uint32_t> lane, nextLane;
+    std::vector<float> s, v; // distance along the lane, speed
+private:
+    const LaneGraph* graph = nullptr;
+    TrafficParams params;
+    std::vector<uint32_t> rng;          // xorshift state per car, for turn choices
+    std::vector<uint32_t> order;        // cars sorted by (lane, s)
+    std::vector<uint32_t> laneFirst;    // per lane + 1: range into order
+    std::vector<uint32_t> laneCursor, previousOrder; // counting sort scratch, kept between steps
+    std::vector<float> gap, dv;         // per car, bumper gap to the leader and closing speed
+    std::vector<uint32_t> mergeFront;   // per lane: the car entering it next from another lane
+    std::vector<float> mergeDistance;   // and its distance to go until it does
+    void sortByLane(WorkerPool* pool);
+    void findLeaders(WorkerPool* pool);
+    void place(size_t i);
+    uint32_t chooseNext(size_t i, uint32_t fromLane);
+};
+
+#endif // TRAFFIC_H
@@ -0,0 +1,57 @@
+#include "transform_store.h"
+#include <algorithm>
+#include <cassert>
+
+uint32_t TransformStore::add(const glm::mat4& local, uint32_t parent) {
+    // parents must come first, or update() would read their worlds before they're resolved
+    assert(parent == kNoParent || parent < worlds.size());
+    locals.push_back(local);
+    worlds.push_back(local);
+    parents.push_back(parent);
+    changed.push_back(0);
+    markChanged(worlds.size() - 1);
+    return (uint32_t)(worlds.size() - 1);
+}
+
+void TransformStore::setLocal(uint32_t id, const glm::mat4& local) {
+    locals[id] = local;
+    markChanged(id);
+}
+
+void TransformStore::update() {
+    if (firstChanged >= worlds.size()) return;
+    // parents come first, so their worlds (and changed flags) are final when a child is reached
+    for (size_t i = firstChanged; i < worlds.size(); i++) {
+        uint32_t p = parents[i];
+        if (!changed[i] && (p == kNoParent || !changed[p])) continue;
+        worlds[i] = (p == kNoParent) ? locals[i] : worlds[p] * locals[i];
+        changed[i] = 1;
+        if (dirtyLo < dirtyHi) {
+            dirtyLo = std::min(dirtyLo, i);
+            dirtyHi = std::max(dirtyHi, i + 1);
+        } else {
+            dirtyLo = i;
+            dirtyHi = i + 1;
+        }
+    }
+    std::fill(changed.begin() + firstChanged, changed.end(), 0);
+    firstChanged = SIZE_MAX;
+}
+
+void TransformStore::clear() {
+    locals.clear();
+    worlds.clear();
+    parents.clear();
+    changed.clear();
+    firstChanged = SIZE_MAX;
+    clearDirty();
+}
+
+void TransformStore::clearDirty() {
+    dirtyLo = dirtyHi = 0;
+}
+
+void TransformStore::markChanged(size_t id) {
+    changed[id] = 1;
+    firstChanged = std::min(firstChanged, id);
+}
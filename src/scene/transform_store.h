@@ -0,0 +1,47 @@
+#ifndef TRANSFORM_STORE_H
+#define TRANSFORM_STORE_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// World matrices computed when something is placed or moved instead of every frame.
+// Transforms form a hierarchy (a composite prop's parts are children of its root)
+// kept in topological order: a parent is always added before its children, so
+// update() resolves every changed subtree in one forward pass over the arrays.
+// Worlds sit back to back (transform ID = index) so they can be uploaded into an
+// instance buffer as is; update() widens a dirty range so only what changed is re-uploaded.
+class TransformStore {
+public:
+    static const uint32_t kNoParent = ~0u;
+
+    // parent must already exist (asserted) or be kNoParent; the world is resolved by update()
+    uint32_t add(const glm::mat4& local, uint32_t parent = kNoParent);
+    // Relative to the parent (world space for roots); moves the whole subtree
+    void setLocal(uint32_t id, const glm::mat4& local);
+    // Recomputes the worlds of changed transforms and their descendants
+    void update();
+    void clear();
+
+    const glm::mat4& local(uint32_t id) const { return locals[id]; }
+    const glm::mat4& world(uint32_t id) const { return worlds[id]; }
+    uint32_t parent(uint32_t id) const { return parents[id]; }
+    const glm::mat4* data() const { return worlds.data(); }
+    size_t size() const { return worlds.size(); }
+
+    // worlds [dirtyBegin, dirtyEnd) changed since the last clearDirty()
+    bool dirty() const { return dirtyLo < dirtyHi; }
+    size_t dirtyBegin() const { return dirtyLo; }
+    size_t dirtyEnd() const { return dirtyHi; }
+    void clearDirty();
+private:
+    std::vector<glm::mat4> locals, worlds;
+    std::vector<uint32_t> parents;
+    std::vector<uint8_t> changed; // local set, or (during update) world recomputed
+    size_t firstChanged = SIZE_MAX; // nothing before it needs work
+    size_t dirtyLo = 0, dirtyHi = 0;
+    void markChanged(size_t id);
+};
+
+#endif // TRANSFORM_STORE_H